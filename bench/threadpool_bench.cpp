@@ -0,0 +1,134 @@
+/**
+ *  (     (
+ *  )\ )  )\ )   (     (
+ * (()/( (()/( ( )\    )\   (    (
+ *  /(_)) /(_)))((_) (((_)  )\   )\
+ * (_))  (_)) ((_)_  )\___ ((_) ((_)
+ * | |   |_ _| | _ )((/ __|| __|| __|
+ * | |__  | |  | _ \ | (__ | _| | _|
+ * |____||___| |___/  \___||___||___|
+ *
+ * @file threadpool_bench.cpp
+ * @author Benjamin Blundell - me@benjamin.computer
+ * @date 18/10/2026
+ * @brief Wake-up latency and throughput of the ThreadPool configurations.
+ *
+ *  threadpool_bench [threads] [latency samples] [throughput tasks]
+ *
+ *  latency    - a task is submitted to an idle pool and the time from submit
+ *               to the task starting is recorded. The pool is left idle for
+ *               a while between samples so workers have parked (or are
+ *               spinning, if the configuration spins).
+ *  throughput - trivial tasks posted as fast as possible, first from one
+ *               producer and then from one producer per worker, timed until
+ *               the last one has run.
+ *
+ *  "fixed" is the pool as it was before spinning and elastic sizing: a
+ *  fixed number of workers that sleep on the condition variable.
+ *
+ */
+
+#include "threadpool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace libcee;
+using Clock = std::chrono::steady_clock;
+
+static double Micros(Clock::duration d) {
+    return std::chrono::duration<double, std::micro>(d).count();
+}
+
+static void Latency(ThreadPool &pool, size_t samples, double &p50, double &p99) {
+    std::vector<double> times;
+    times.reserve(samples);
+    for (size_t i = 0; i < samples; ++i) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        Clock::time_point submitted = Clock::now();
+        auto started = pool.execute([]() { return Clock::now(); });
+        times.push_back(Micros(started.get() - submitted));
+    }
+    std::sort(times.begin(), times.end());
+    p50 = times[times.size() / 2];
+    p99 = times[std::min(times.size() - 1, times.size() * 99 / 100)];
+}
+
+// Millions of tasks a second with producers threads submitting tasks between them.
+static double Throughput(ThreadPool &pool, size_t tasks, size_t producers) {
+    std::atomic<size_t> done{ 0 };
+    Clock::time_point start = Clock::now();
+
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p) {
+        size_t count = tasks / producers + (p < tasks % producers ? 1 : 0);
+        threads.emplace_back([&pool, &done, count]() {
+            for (size_t i = 0; i < count; ++i) {
+                pool.post([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+            }
+        });
+    }
+    for (std::thread &thread : threads) { thread.join(); }
+    while (done.load(std::memory_order_relaxed) < tasks) { std::this_thread::yield(); }
+
+    return tasks / Micros(Clock::now() - start);
+}
+
+static void Run(const char *name, size_t threads, const ThreadPoolOptions &options,
+                size_t samples, size_t tasks) {
+    double p50 = 0, p99 = 0, one = 0, many = 0;
+    {
+        ThreadPool pool(threads, options);
+        Latency(pool, samples, p50, p99);
+    }
+    {
+        ThreadPool pool(threads, options);
+        one = Throughput(pool, tasks, 1);
+    }
+    size_t live = 0;
+    {
+        ThreadPool pool(threads, options);
+        many = Throughput(pool, tasks, threads);
+        live = pool.size();
+    }
+    std::printf("%-22s %9.1f %9.1f %10.2f %10.2f %6zu\n", name, p50, p99, one, many, live);
+}
+
+int main(int argc, char **argv) {
+    size_t threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+    size_t samples = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 5000;
+    size_t tasks = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1000000;
+    if (threads == 0) { threads = 1; }
+
+    std::printf("%zu workers, %u hardware threads, %zu latency samples, %zu tasks\n\n",
+                threads, std::thread::hardware_concurrency(), samples, tasks);
+    std::printf("%-22s %9s %9s %10s %10s %6s\n", "", "p50 us", "p99 us", "1 prod M/s", "N prod M/s", "live");
+
+    ThreadPoolOptions fixed;
+    Run("fixed", threads, fixed, samples, tasks);
+
+    for (unsigned int spin : { 200u, 2000u }) {
+        ThreadPoolOptions options;
+        options.spin_iterations = spin;
+        Run(("spin " + std::to_string(spin)).c_str(), threads, options, samples, tasks);
+    }
+
+    // Elastic pools start at a quarter of the workers and may grow to all of them.
+    size_t min_threads = std::max<size_t>(1, threads / 4);
+    ThreadPoolOptions elastic;
+    elastic.elastic = true;
+    elastic.max_threads = threads;
+    Run(("elastic " + std::to_string(min_threads) + ".." + std::to_string(threads)).c_str(),
+        min_threads, elastic, samples, tasks);
+
+    elastic.spin_iterations = 2000;
+    Run(("elastic spin " + std::to_string(min_threads) + ".." + std::to_string(threads)).c_str(),
+        min_threads, elastic, samples, tasks);
+    return 0;
+}
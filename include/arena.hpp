@@ -0,0 +1,171 @@
+#ifndef __libcee_ARENA_H__
+#define __libcee_ARENA_H__
+
+/**
+ *  (     (                           
+ *  )\ )  )\ )   (     (              
+ * (()/( (()/( ( )\    )\   (    (    
+ *  /(_)) /(_)))((_) (((_)  )\   )\   
+ * (_))  (_)) ((_)_  )\___ ((_) ((_)  
+ * | |   |_ _| | _ )((/ __|| __|| __| 
+ * | |__  | |  | _ \ | (__ | _| | _|  
+ * |____||___| |___/  \___||___||___| 
+ *                                             
+ * @file arena.hpp
+ * @author Benjamin Blundell - me@benjamin.computer
+ * @date 18/10/2026
+ * @brief A simple bump allocator for short lived scratch memory.
+ *
+ *  Memory is handed out from large blocks and is only given back all at
+ *  once with reset(). On POSIX each block is mapped straight from the kernel
+ *  and not touched until it is first used, so when an Arena lives on a
+ *  pinned thread its pages land on that thread's NUMA node (first-touch).
+ *  On Windows blocks come from malloc and may be recycled heap memory.
+ *
+ *  Arena arena;
+ *  std::vector<float, ArenaAllocator<float>> v{ArenaAllocator<float>(arena)};
+ *  ...
+ *  arena.reset();
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace libcee {
+
+class Arena {
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 256 * 1024;
+
+    explicit Arena(size_t block_size = DEFAULT_BLOCK_SIZE) :
+        _block_size(block_size == 0 ? DEFAULT_BLOCK_SIZE : block_size) {}
+
+    ~Arena() {
+        for (Block &block : _blocks) { _unmap(block); }
+    }
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    /**
+     * Allocate bytes with the given alignment. Never returns nullptr.
+     *
+     * @param bytes - number of bytes
+     * @param align - a power of two
+     *
+     * @return pointer into the arena, valid until reset() or destruction
+     */
+    void *allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+        while (_current < _blocks.size()) {
+            Block &block = _blocks[_current];
+            uintptr_t base = reinterpret_cast<uintptr_t>(block.data);
+            uintptr_t p = (base + _offset + align - 1) & ~(uintptr_t)(align - 1);
+            if (p + bytes <= base + block.size) {
+                _offset = (p + bytes) - base;
+                _used += bytes;
+                return reinterpret_cast<void *>(p);
+            }
+            // Try the next (already reserved) block after a reset.
+            _current++;
+            _offset = 0;
+        }
+
+        size_t size = bytes + align > _block_size ? bytes + align : _block_size;
+        Block block = _map(size);
+        _blocks.push_back(block);
+        _reserved += block.size;
+        _current = _blocks.size() - 1;
+        _offset = 0;
+        return allocate(bytes, align);
+    }
+
+    template <typename T>
+    T *allocate_array(size_t count) {
+        return static_cast<T *>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    // Forget all allocations but keep the blocks around for reuse.
+    void reset() {
+        _current = 0;
+        _offset = 0;
+        _used = 0;
+    }
+
+    size_t bytes_used() const { return _used; }
+    size_t bytes_reserved() const { return _reserved; }
+
+private:
+    struct Block {
+        char *data;
+        size_t size;
+    };
+
+    // Map rather than malloc: malloc's mmap threshold moves once a mapped
+    //  chunk is freed, after which a block could be heap memory already
+    //  touched on another node.
+    static Block _map(size_t size) {
+#ifndef _WIN32
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        size = (size + page - 1) / page * page;
+        void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data == MAP_FAILED) { throw std::bad_alloc(); }
+#else
+        void *data = std::malloc(size);
+        if (data == nullptr) { throw std::bad_alloc(); }
+#endif
+        return { static_cast<char *>(data), size };
+    }
+
+    static void _unmap(const Block &block) {
+#ifndef _WIN32
+        munmap(block.data, block.size);
+#else
+        std::free(block.data);
+#endif
+    }
+
+    std::vector<Block> _blocks;
+    size_t _block_size;
+    size_t _current = 0;
+    size_t _offset = 0;
+    size_t _used = 0;
+    size_t _reserved = 0;
+};
+
+// A standard library allocator that draws from an Arena. deallocate is a
+//  no-op; memory comes back when the arena is reset.
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(Arena &arena) : _arena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : _arena(other._arena) {}
+
+    T *allocate(size_t n) { return _arena->allocate_array<T>(n); }
+    void deallocate(T *, size_t) {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const { return _arena == other._arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &other) const { return _arena != other._arena; }
+
+private:
+    template <typename U> friend class ArenaAllocator;
+    Arena *_arena;
+};
+
+}
+
+#endif
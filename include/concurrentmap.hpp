@@ -0,0 +1,420 @@
+#ifndef __libcee_CONCURRENTMAP_H__
+#define __libcee_CONCURRENTMAP_H__
+
+/**
+ *  (     (
+ *  )\ )  )\ )   (     (
+ * (()/( (()/( ( )\    )\   (    (
+ *  /(_)) /(_)))((_) (((_)  )\   )\
+ * (_))  (_)) ((_)_  )\___ ((_) ((_)
+ * | |   |_ _| | _ )((/ __|| __|| __|
+ * | |__  | |  | _ \ | (__ | _| | _|
+ * |____||___| |___/  \___||___||___|
+ *
+ * @file concurrentmap.hpp
+ * @author Benjamin Blundell - me@benjamin.computer
+ * @date 18/10/2026
+ * @brief A hash map for gathering results from many threads at once.
+ *
+ *  FlatMap is a single threaded open addressing table. One control byte per
+ *  slot sits in its own dense array, so a probe only touches the key/value
+ *  slots when the control byte already looks like a match.
+ *
+ *  ConcurrentHashMap splits keys over shards, each a FlatMap behind its own
+ *  lock, and merges values with upsert rather than making callers do a
+ *  find-then-insert under a lock of their own:
+ *
+ *  ConcurrentHashMap<std::string, uint64_t> counts;
+ *  pool.execute([&]() { counts.upsert(GetFileExtension(path), 1); });
+ *
+ *  When every worker writes a lot, give each its own Combiner instead. They
+ *  take no locks at all, and are already split by shard, so merging runs one
+ *  task per shard with no contention:
+ *
+ *  std::vector<ConcurrentHashMap<std::string, uint64_t>::Combiner> parts;
+ *  for (size_t i = 0; i < pool.max_size(); ++i) { parts.push_back(counts.make_combiner()); }
+ *  ... in a task: parts[ThreadPool::current_worker()->index].upsert(token, 1);
+ *  counts.merge(parts, pool);
+ *
+ *  Size the combiners by max_size(), not size(): an elastic pool grows and
+ *  shrinks, and its worker indices go up to max_size() - 1.
+ *
+ *  Keys and values must be default constructible. There is no erase.
+ *
+ */
+
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "threadpool.hpp"
+
+namespace libcee {
+
+// The default way to combine two values for the same key.
+struct AddMerge {
+    template <typename V>
+    void operator()(V &existing, const V &incoming) const { existing += incoming; }
+};
+
+// Spread the bits of a hash about; std::hash on integers is the identity.
+inline uint64_t MixHash(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+template <typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+class FlatMap {
+public:
+    FlatMap() = default;
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    void reserve(size_t count) {
+        size_t capacity = 16;
+        while (capacity * 3 / 4 < count) { capacity *= 2; }
+        if (capacity > _ctrl.size()) { _rehash(capacity); }
+    }
+
+    void clear() {
+        _ctrl.clear();
+        _slots.clear();
+        _size = 0;
+        _shift = 64;
+    }
+
+    // Insert value if key is new, otherwise merge(existing, value).
+    template <typename F = AddMerge>
+    void upsert(const K &key, const V &value, F merge = F()) {
+        upsert_hashed(mix(key), key, value, merge);
+    }
+
+    // Call fn on the value for key, default constructing it first if new.
+    template <typename F>
+    void update(const K &key, F fn) {
+        fn(*find_or_insert(mix(key), key).first);
+    }
+
+    V &operator[](const K &key) { return *find_or_insert(mix(key), key).first; }
+
+    const V *find(const K &key) const { return find_hashed(mix(key), key); }
+
+    // fn(const K &key, V &value) for every entry.
+    template <typename F>
+    void for_each(F fn) {
+        for (size_t i = 0; i < _ctrl.size(); ++i) {
+            if (_ctrl[i]) { fn(static_cast<const K &>(_slots[i].first), _slots[i].second); }
+        }
+    }
+
+    template <typename F>
+    void for_each(F fn) const {
+        for (size_t i = 0; i < _ctrl.size(); ++i) {
+            if (_ctrl[i]) { fn(_slots[i].first, _slots[i].second); }
+        }
+    }
+
+    // The versions below take a hash already put through mix(), so callers
+    //  that also use it to pick a shard only hash once.
+
+    static uint64_t mix(const K &key) { return MixHash(Hash()(key)); }
+
+    template <typename F>
+    void upsert_hashed(uint64_t hash, const K &key, const V &value, F &merge) {
+        auto res = find_or_insert(hash, key);
+        if (res.second) {
+            *res.first = value;
+        } else {
+            merge(*res.first, value);
+        }
+    }
+
+    template <typename F>
+    void upsert_hashed(uint64_t hash, const K &key, V &&value, F &merge) {
+        auto res = find_or_insert(hash, key);
+        if (res.second) {
+            *res.first = std::move(value);
+        } else {
+            merge(*res.first, value);
+        }
+    }
+
+    // Pointer to the value for key and whether it was just added. The
+    //  pointer is good until the next insert.
+    std::pair<V *, bool> find_or_insert(uint64_t hash, const K &key) {
+        if ((_size + 1) * 4 > _ctrl.size() * 3) {
+            _rehash(_ctrl.size() == 0 ? 16 : _ctrl.size() * 2);
+        }
+        uint8_t tag = _tag(hash);
+        size_t mask = _ctrl.size() - 1;
+        for (size_t i = _home(hash); ; i = (i + 1) & mask) {
+            if (_ctrl[i] == 0) {
+                _ctrl[i] = tag;
+                _slots[i].first = key;
+                _size++;
+                return { &_slots[i].second, true };
+            }
+            if (_ctrl[i] == tag && Equal()(_slots[i].first, key)) {
+                return { &_slots[i].second, false };
+            }
+        }
+    }
+
+    const V *find_hashed(uint64_t hash, const K &key) const {
+        if (_size == 0) { return nullptr; }
+        uint8_t tag = _tag(hash);
+        size_t mask = _ctrl.size() - 1;
+        for (size_t i = _home(hash); ; i = (i + 1) & mask) {
+            if (_ctrl[i] == 0) { return nullptr; }
+            if (_ctrl[i] == tag && Equal()(_slots[i].first, key)) { return &_slots[i].second; }
+        }
+    }
+
+    // Move every entry into other, merging where other already has the key.
+    //  Leaves this map empty.
+    template <typename F>
+    void drain_into(FlatMap &other, F &merge) {
+        other.reserve(other.size() + _size);
+        for (size_t i = 0; i < _ctrl.size(); ++i) {
+            if (_ctrl[i]) { other.upsert_hashed(mix(_slots[i].first), _slots[i].first, std::move(_slots[i].second), merge); }
+        }
+        clear();
+    }
+
+private:
+    // The top bits pick the home slot, the low seven make the tag. The high
+    //  bit of a tag is always set so zero can mean empty.
+    size_t _home(uint64_t hash) const { return (size_t)(hash >> _shift); }
+    static uint8_t _tag(uint64_t hash) { return (uint8_t)(0x80 | (hash & 0x7f)); }
+
+    void _rehash(size_t capacity) {
+        std::vector<uint8_t> ctrl(capacity, 0);
+        std::vector<std::pair<K, V>> slots(capacity);
+        unsigned int bits = 0;
+        while ((size_t(1) << bits) < capacity) { bits++; }
+        unsigned int shift = 64 - bits;
+
+        size_t mask = capacity - 1;
+        for (size_t j = 0; j < _ctrl.size(); ++j) {
+            if (!_ctrl[j]) { continue; }
+            uint64_t hash = mix(_slots[j].first);
+            size_t i = (size_t)(hash >> shift);
+            while (ctrl[i]) { i = (i + 1) & mask; }
+            ctrl[i] = _ctrl[j];
+            slots[i] = std::move(_slots[j]);
+        }
+
+        _ctrl.swap(ctrl);
+        _slots.swap(slots);
+        _shift = shift;
+    }
+
+    std::vector<uint8_t> _ctrl;
+    std::vector<std::pair<K, V>> _slots;
+    size_t _size = 0;
+    unsigned int _shift = 64;
+};
+
+template <typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+class ConcurrentHashMap {
+public:
+    using Map = FlatMap<K, V, Hash, Equal>;
+
+    // shard_count is rounded up to a power of two, at most 1024.
+    explicit ConcurrentHashMap(size_t shard_count = 64) {
+        size_t count = 1;
+        while (count < shard_count && count < 1024) { count *= 2; }
+        _mask = count - 1;
+        _shards.reset(new Shard[count]);
+    }
+
+    ConcurrentHashMap(const ConcurrentHashMap &) = delete;
+    ConcurrentHashMap &operator=(const ConcurrentHashMap &) = delete;
+
+    size_t shard_count() const { return _mask + 1; }
+
+    template <typename F = AddMerge>
+    void upsert(const K &key, const V &value, F merge = F()) {
+        uint64_t hash = Map::mix(key);
+        Shard &shard = _shards[_shard_of(hash)];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.map.upsert_hashed(hash, key, value, merge);
+    }
+
+    template <typename F>
+    void update(const K &key, F fn) {
+        uint64_t hash = Map::mix(key);
+        Shard &shard = _shards[_shard_of(hash)];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        fn(*shard.map.find_or_insert(hash, key).first);
+    }
+
+    void insert_or_assign(const K &key, const V &value) {
+        update(key, [&](V &existing) { existing = value; });
+    }
+
+    std::optional<V> find(const K &key) const {
+        uint64_t hash = Map::mix(key);
+        const Shard &shard = _shards[_shard_of(hash)];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        const V *value = shard.map.find_hashed(hash, key);
+        if (value == nullptr) { return std::nullopt; }
+        return *value;
+    }
+
+    size_t size() const {
+        size_t count = 0;
+        for (size_t s = 0; s <= _mask; ++s) {
+            std::lock_guard<std::mutex> lock(_shards[s].mutex);
+            count += _shards[s].map.size();
+        }
+        return count;
+    }
+
+    // fn(const K &key, V &value) for every entry, holding one shard lock at
+    //  a time. fn must not call back into this map.
+    template <typename F>
+    void for_each(F fn) {
+        for (size_t s = 0; s <= _mask; ++s) {
+            std::lock_guard<std::mutex> lock(_shards[s].mutex);
+            _shards[s].map.for_each(fn);
+        }
+    }
+
+    void clear() {
+        for (size_t s = 0; s <= _mask; ++s) {
+            std::lock_guard<std::mutex> lock(_shards[s].mutex);
+            _shards[s].map.clear();
+        }
+    }
+
+    // Thread local accumulation, already split the same way as the map.
+    //  A Combiner is not thread safe; give each thread its own.
+    class Combiner {
+    public:
+        template <typename F = AddMerge>
+        void upsert(const K &key, const V &value, F merge = F()) {
+            uint64_t hash = Map::mix(key);
+            _parts[(hash >> SHARD_SHIFT) & _mask].upsert_hashed(hash, key, value, merge);
+        }
+
+        template <typename F>
+        void update(const K &key, F fn) {
+            uint64_t hash = Map::mix(key);
+            fn(*_parts[(hash >> SHARD_SHIFT) & _mask].find_or_insert(hash, key).first);
+        }
+
+        size_t size() const {
+            size_t count = 0;
+            for (const Map &part : _parts) { count += part.size(); }
+            return count;
+        }
+
+    private:
+        friend class ConcurrentHashMap;
+        explicit Combiner(size_t mask) : _parts(mask + 1), _mask(mask) {}
+
+        std::vector<Map> _parts;
+        size_t _mask;
+    };
+
+    Combiner make_combiner() const { return Combiner(_mask); }
+
+    /**
+     * Fold a combiner into the map, one shard lock at a time. The combiner
+     * is left empty and can be reused.
+     *
+     * @param combiner - from make_combiner() on this map
+     * @param merge - merge(existing, incoming) for keys in both
+     */
+    template <typename F = AddMerge>
+    void merge(Combiner &combiner, F merge = F()) {
+        _check(combiner);
+        for (size_t s = 0; s <= _mask; ++s) {
+            std::lock_guard<std::mutex> lock(_shards[s].mutex);
+            combiner._parts[s].drain_into(_shards[s].map, merge);
+        }
+    }
+
+    /**
+     * Fold many combiners into the map, one pool task per shard, so no two
+     * tasks ever want the same lock. The combiners are left empty.
+     *
+     * This waits on the pool, so it must not be called from a task running
+     * on pool. If merge throws, every task is still waited for before the
+     * first exception is rethrown, and the map and combiners are left part
+     * merged.
+     *
+     * @param combiners - from make_combiner() on this map
+     * @param pool - the ThreadPool to merge on
+     * @param merge - merge(existing, incoming) for keys in both
+     */
+    template <typename F = AddMerge>
+    void merge(std::vector<Combiner> &combiners, ThreadPool &pool, F merge = F()) {
+        for (const Combiner &combiner : combiners) { _check(combiner); }
+        std::vector<std::future<void>> futures;
+        try {
+            for (size_t s = 0; s <= _mask; ++s) {
+                futures.push_back(pool.execute([this, s, &combiners, merge]() mutable {
+                    std::lock_guard<std::mutex> lock(_shards[s].mutex);
+                    for (Combiner &combiner : combiners) {
+                        combiner._parts[s].drain_into(_shards[s].map, merge);
+                    }
+                }));
+            }
+        } catch (...) {
+            for (auto &fut : futures) { fut.wait(); }
+            throw;
+        }
+
+        // The tasks hold combiners by reference, so none may still be running
+        //  when an exception leaves here.
+        std::exception_ptr error;
+        for (auto &fut : futures) {
+            try {
+                fut.get();
+            } catch (...) {
+                if (!error) { error = std::current_exception(); }
+            }
+        }
+        if (error) { std::rethrow_exception(error); }
+    }
+
+private:
+    // FlatMap takes its slot from the top bits and its tag from the low
+    //  seven, so shards are picked from the bits just above the tag.
+    static constexpr unsigned int SHARD_SHIFT = 7;
+
+    size_t _shard_of(uint64_t hash) const { return (size_t)(hash >> SHARD_SHIFT) & _mask; }
+
+    // A combiner split for a different number of shards would put keys in
+    //  the wrong shard, or index past the end.
+    void _check(const Combiner &combiner) const {
+        if (combiner._parts.size() != shard_count()) {
+            throw std::invalid_argument("Combiner was made for a map with a different shard count");
+        }
+    }
+
+    // Padded so neighbouring shards' locks don't share a cache line.
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        Map map;
+    };
+
+    std::unique_ptr<Shard[]> _shards;
+    size_t _mask = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,500 @@
+#ifndef __libcee_CORO_H__
+#define __libcee_CORO_H__
+
+/**
+ *  (     (                           
+ *  )\ )  )\ )   (     (              
+ * (()/( (()/( ( )\    )\   (    (    
+ *  /(_)) /(_)))((_) (((_)  )\   )\   
+ * (_))  (_)) ((_)_  )\___ ((_) ((_)  
+ * | |   |_ _| | _ )((/ __|| __|| __| 
+ * | |__  | |  | _ \ | (__ | _| | _|  
+ * |____||___| |___/  \___||___||___| 
+ *                                             
+ * @file coro.hpp
+ * @author Benjamin Blundell - me@benjamin.computer
+ * @date 18/10/2026
+ * @brief C++20 coroutines on top of the ThreadPool. Needs cpp_std=c++20.
+ *
+ *  A Task is lazy; nothing runs until it is awaited. Awaiting ScheduleOn
+ *  moves the rest of a coroutine onto a pool, so waiting on a dependency
+ *  does not hold a thread the way std::future::get does.
+ *
+ *  Task<size_t> CountBytes(ThreadPool &io, std::string path) {
+ *      std::vector<char> data = co_await ReadFileAsync(io, path);
+ *      co_return data.size();
+ *  }
+ *
+ *  Task<size_t> Total(ThreadPool &io, std::vector<std::string> paths) {
+ *      std::vector<Task<size_t>> tasks;
+ *      for (auto &p : paths) { tasks.push_back(CountBytes(io, p)); }
+ *      std::vector<size_t> sizes = co_await WhenAll(std::move(tasks));
+ *      co_return std::accumulate(sizes.begin(), sizes.end(), size_t(0));
+ *  }
+ *
+ *  size_t total = SyncWait(Total(io, paths));
+ *
+ */
+
+#if __cplusplus >= 202002L && __has_include(<coroutine>)
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "file.hpp"
+#include "threadpool.hpp"
+
+namespace libcee {
+
+template <typename T = void> class Task;
+
+namespace detail {
+
+struct TaskPromiseBase {
+    //when the task finishes, control transfers straight to whoever awaited it.
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) noexcept {
+            return handle.promise().continuation;
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { exception = std::current_exception(); }
+
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+    std::exception_ptr exception;
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    Task<T> get_return_object() noexcept;
+
+    template <typename U>
+    void return_value(U &&value) { _value.emplace(std::forward<U>(value)); }
+
+    T result() {
+        if (exception) { std::rethrow_exception(exception); }
+        return std::move(*_value);
+    }
+
+private:
+    std::optional<T> _value;
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object() noexcept;
+
+    void return_void() noexcept {}
+
+    void result() {
+        if (exception) { std::rethrow_exception(exception); }
+    }
+};
+
+//an eager coroutine that nobody awaits and that frees itself when done. Used
+//  to start tasks from plain code and from the combinators below.
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+}
+
+template <typename T>
+class Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+    Task() = default;
+    explicit Task(std::coroutine_handle<promise_type> handle) : _handle(handle) {}
+    Task(Task &&other) noexcept : _handle(std::exchange(other._handle, nullptr)) {}
+    Task &operator=(Task &&other) noexcept {
+        if (this != &other) {
+            if (_handle) { _handle.destroy(); }
+            _handle = std::exchange(other._handle, nullptr);
+        }
+        return *this;
+    }
+    ~Task() {
+        if (_handle) { _handle.destroy(); }
+    }
+
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    bool valid() const { return static_cast<bool>(_handle); }
+
+    //starts the task and suspends the awaiting coroutine until it is done.
+    //  An empty or moved-from Task has nothing to run, so awaiting one throws.
+    auto operator co_await() const {
+        if (!_handle) { throw std::logic_error("co_await on an empty Task"); }
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() const noexcept { return handle.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+            T await_resume() { return handle.promise().result(); }
+        };
+        return Awaiter{ _handle };
+    }
+
+private:
+    std::coroutine_handle<promise_type> _handle;
+};
+
+namespace detail {
+
+template <typename T>
+inline Task<T> TaskPromise<T>::get_return_object() noexcept {
+    return Task<T>{ std::coroutine_handle<TaskPromise<T>>::from_promise(*this) };
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+    return Task<void>{ std::coroutine_handle<TaskPromise<void>>::from_promise(*this) };
+}
+
+}
+
+/**
+ * Resume the awaiting coroutine on one of the pool's workers
+ *
+ * @param pool - the ThreadPool to continue on
+ *
+ * @return an awaitable
+ */
+inline auto ScheduleOn(ThreadPool &pool) {
+    struct Awaiter {
+        ThreadPool &pool;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) {
+            pool.post([handle]() { handle.resume(); });
+        }
+        void await_resume() const noexcept {}
+    };
+    return Awaiter{ pool };
+}
+
+namespace detail {
+
+template <typename T>
+struct SyncWaitState {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+    std::optional<std::conditional_t<std::is_void_v<T>, char, T>> value;
+    std::exception_ptr exception;
+};
+
+template <typename T>
+Detached SyncWaitRun(Task<T> task, SyncWaitState<T> *state) {
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await task;
+        } else {
+            state->value.emplace(co_await task);
+        }
+    } catch (...) {
+        state->exception = std::current_exception();
+    }
+    //notify under the lock; the waiter owns state and may return straight away.
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->done = true;
+    state->cv.notify_one();
+}
+
+}
+
+/**
+ * Block the calling thread until the task is finished. This is the bridge
+ * from plain code into coroutines; do not call it from a pool worker that
+ * the task itself needs.
+ *
+ * @param task - the task to run
+ *
+ * @return the task's result, or rethrows its exception
+ */
+template <typename T>
+T SyncWait(Task<T> task) {
+    detail::SyncWaitState<T> state;
+    detail::SyncWaitRun(std::move(task), &state);
+
+    std::unique_lock<std::mutex> lock(state.mutex);
+    state.cv.wait(lock, [&]() { return state.done; });
+
+    if (state.exception) { std::rethrow_exception(state.exception); }
+    if constexpr (!std::is_void_v<T>) { return std::move(*state.value); }
+}
+
+namespace detail {
+
+//the count starts at tasks + 1; the extra one belongs to the awaiter so a task
+//  that finishes while the others are still being started can't resume the
+//  parent too early.
+struct WhenAllCounter {
+    std::atomic<size_t> count;
+    std::coroutine_handle<> continuation;
+
+    void arrive() {
+        if (count.fetch_sub(1, std::memory_order_acq_rel) == 1) { continuation.resume(); }
+    }
+};
+
+template <typename T>
+using WhenSlot = std::optional<std::conditional_t<std::is_void_v<T>, char, T>>;
+
+template <typename T>
+Detached WhenAllRun(Task<T> task, WhenSlot<T> *slot, std::exception_ptr *exception,
+                    WhenAllCounter *counter) {
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await task;
+            slot->emplace();
+        } else {
+            slot->emplace(co_await task);
+        }
+    } catch (...) {
+        *exception = std::current_exception();
+    }
+    counter->arrive();
+}
+
+template <typename T>
+struct WhenAllAwaiter {
+    std::vector<Task<T>> &tasks;
+    std::vector<WhenSlot<T>> &slots;
+    std::vector<std::exception_ptr> &exceptions;
+    WhenAllCounter &counter;
+
+    bool await_ready() const noexcept { return tasks.empty(); }
+    bool await_suspend(std::coroutine_handle<> handle) {
+        counter.continuation = handle;
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            WhenAllRun(std::move(tasks[i]), &slots[i], &exceptions[i], &counter);
+        }
+        return counter.count.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+    void await_resume() const noexcept {}
+};
+
+}
+
+/**
+ * Run all the tasks concurrently and wait for every one of them. The tasks
+ * are started on the current thread; use ScheduleOn inside them to spread
+ * the work out. If any task throws, the first exception (by position) is
+ * rethrown once they have all finished.
+ *
+ * @param tasks - the tasks to run
+ *
+ * @return a task giving the results in the same order as the input
+ */
+template <typename T>
+Task<std::vector<T>> WhenAll(std::vector<Task<T>> tasks) {
+    std::vector<detail::WhenSlot<T>> slots(tasks.size());
+    std::vector<std::exception_ptr> exceptions(tasks.size());
+    detail::WhenAllCounter counter{ tasks.size() + 1, nullptr };
+
+    co_await detail::WhenAllAwaiter<T>{ tasks, slots, exceptions, counter };
+
+    for (auto &exception : exceptions) {
+        if (exception) { std::rethrow_exception(exception); }
+    }
+
+    std::vector<T> results;
+    results.reserve(slots.size());
+    for (auto &slot : slots) { results.push_back(std::move(*slot)); }
+    co_return results;
+}
+
+inline Task<void> WhenAll(std::vector<Task<void>> tasks) {
+    std::vector<detail::WhenSlot<void>> slots(tasks.size());
+    std::vector<std::exception_ptr> exceptions(tasks.size());
+    detail::WhenAllCounter counter{ tasks.size() + 1, nullptr };
+
+    co_await detail::WhenAllAwaiter<void>{ tasks, slots, exceptions, counter };
+
+    for (auto &exception : exceptions) {
+        if (exception) { std::rethrow_exception(exception); }
+    }
+}
+
+namespace detail {
+
+//shared between the parent and every child, as the losers carry on running
+//  after the parent has been resumed.
+template <typename T>
+struct WhenAnyState {
+    std::atomic<bool> won{ false };
+    std::atomic<int> pending{ 2 };  // the winner and the awaiter both arrive
+    std::coroutine_handle<> continuation;
+    size_t index = 0;
+    WhenSlot<T> value;
+    std::exception_ptr exception;
+
+    void arrive() {
+        if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) { continuation.resume(); }
+    }
+};
+
+template <typename T>
+Detached WhenAnyRun(Task<T> task, size_t index, std::shared_ptr<WhenAnyState<T>> state) {
+    WhenSlot<T> value;
+    std::exception_ptr exception;
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await task;
+            value.emplace();
+        } else {
+            value.emplace(co_await task);
+        }
+    } catch (...) {
+        exception = std::current_exception();
+    }
+
+    if (!state->won.exchange(true, std::memory_order_acq_rel)) {
+        state->index = index;
+        state->value = std::move(value);
+        state->exception = exception;
+        state->arrive();
+    }
+}
+
+template <typename T>
+struct WhenAnyAwaiter {
+    std::vector<Task<T>> &tasks;
+    std::shared_ptr<WhenAnyState<T>> &state;
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> handle) {
+        state->continuation = handle;
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            WhenAnyRun(std::move(tasks[i]), i, state);
+        }
+        return state->pending.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+    void await_resume() const noexcept {}
+};
+
+}
+
+/**
+ * Run all the tasks concurrently and resume as soon as the first finishes.
+ * The others are not cancelled; they run to completion in the background,
+ * so anything they reference must outlive them.
+ *
+ * @param tasks - the tasks to run, must not be empty
+ *
+ * @return a task giving the index of the first task to finish and its value
+ */
+template <typename T>
+Task<std::pair<size_t, T>> WhenAny(std::vector<Task<T>> tasks) {
+    if (tasks.empty()) { throw std::invalid_argument("WhenAny needs at least one task"); }
+
+    auto state = std::make_shared<detail::WhenAnyState<T>>();
+    co_await detail::WhenAnyAwaiter<T>{ tasks, state };
+
+    if (state->exception) { std::rethrow_exception(state->exception); }
+    co_return std::pair<size_t, T>(state->index, std::move(*state->value));
+}
+
+inline Task<size_t> WhenAny(std::vector<Task<void>> tasks) {
+    if (tasks.empty()) { throw std::invalid_argument("WhenAny needs at least one task"); }
+
+    auto state = std::make_shared<detail::WhenAnyState<void>>();
+    co_await detail::WhenAnyAwaiter<void>{ tasks, state };
+
+    if (state->exception) { std::rethrow_exception(state->exception); }
+    co_return state->index;
+}
+
+namespace detail {
+
+//runs a blocking read on the I/O pool then resumes the awaiting coroutine
+//  there. The awaiting coroutine holds no thread while the read is queued.
+template <typename R, typename F>
+struct BlockingIoAwaiter {
+    ThreadPool &pool;
+    F read;
+    std::optional<R> result;
+    std::exception_ptr exception;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) {
+        pool.post([this, handle]() {
+            try {
+                result.emplace(read());
+            } catch (...) {
+                exception = std::current_exception();
+            }
+            handle.resume();
+        });
+    }
+    R await_resume() {
+        if (exception) { std::rethrow_exception(exception); }
+        return std::move(*result);
+    }
+};
+
+template <typename R, typename F>
+BlockingIoAwaiter<R, F> MakeIoAwaiter(ThreadPool &pool, F &&read) {
+    return BlockingIoAwaiter<R, F>{ pool, std::forward<F>(read), std::nullopt, nullptr };
+}
+
+}
+
+/**
+ * Read a whole file on the I/O pool. The awaiting coroutine resumes on that
+ * pool; co_await ScheduleOn(other) afterwards to hop back to compute workers.
+ *
+ * @param pool - the pool that does the blocking I/O
+ * @param filename - the file path
+ *
+ * @return an awaitable giving the bytes of the file
+ */
+inline auto ReadFileAsync(ThreadPool &pool, std::string filename) {
+    return detail::MakeIoAwaiter<std::vector<char>>(pool,
+        [filename = std::move(filename)]() { return ReadFile(filename); });
+}
+
+/**
+ * Read a text file by lines on the I/O pool.
+ *
+ * @param pool - the pool that does the blocking I/O
+ * @param filename - the file path
+ *
+ * @return an awaitable giving the lines of the file
+ */
+inline auto ReadFileLinesAsync(ThreadPool &pool, std::string filename) {
+    return detail::MakeIoAwaiter<std::vector<std::string>>(pool,
+        [filename = std::move(filename)]() { return ReadFileLines(filename); });
+}
+
+}
+
+#endif
+
+#endif
@@ -23,18 +23,132 @@
 #include <string>
 #include <iostream>
 #include <filesystem>
+#include <cstdint>
+#include <string_view>
 #ifdef _WIN32
 #define  _SILENCE_EXPERIMENTAL_FILESYSTEM_DEPRECATION_WARNING
 #include <experimental/filesystem>
 #endif
 
+#include "pathlist.hpp"
+
 namespace libcee {
 
+class ThreadPool;
+
+// Symlink only comes back when links are not followed.
+enum class FileType : uint8_t { None, Regular, Directory, Symlink, Other };
+
+// Metadata for one path. type is None if the path could not be stat'd.
+struct FileStat {
+    FileType type = FileType::None;
+    uint64_t size = 0;
+    int64_t mtime_ns = 0;   // nanoseconds since the epoch
+};
+
+// Metadata for many paths as a structure of arrays, in the order the paths
+//  were given.
+struct FileStats {
+    std::vector<FileType> types;
+    std::vector<uint64_t> sizes;
+    std::vector<int64_t> mtimes_ns;
+
+    size_t count() const { return types.size(); }
+    bool exists(size_t i) const { return types[i] != FileType::None; }
+    FileStat at(size_t i) const { return { types[i], sizes[i], mtimes_ns[i] }; }
+};
+
+// How FileWriter and WriteFile put data on disk.
+struct WriteOptions {
+    bool atomic = false;            // write a temp file in the same directory, rename it over on close
+    bool sync = false;              // fdatasync before close; atomic writes always sync
+    bool direct = false;            // O_DIRECT where the filesystem supports it
+    uint64_t preallocate = 0;       // reserve this many bytes up front, without growing the file;
+                                    //  close() gives back what was not written. WriteFile
+                                    //  reserves big files (16MB and up) itself
+    size_t buffer_size = 1 << 20;   // rounded up to a multiple of 4096
+};
+
+// A buffered file writer. Data is gathered in a large, page aligned buffer
+//  and handed to the kernel in big writes. With atomic set the target only
+//  appears (whole) when close() succeeds; a writer destroyed without close()
+//  throws its temp file away.
+class FileWriter {
+public:
+    FileWriter() = default;
+    explicit FileWriter(const std::string &filename, const WriteOptions &options = WriteOptions());
+    ~FileWriter();
+
+    FileWriter(const FileWriter &) = delete;
+    FileWriter &operator=(const FileWriter &) = delete;
+
+    void open(const std::string &filename, const WriteOptions &options = WriteOptions());
+    void write(const void *data, size_t size);
+    void write(std::string_view data) { write(data.data(), data.size()); }
+    void flush();
+    void close();
+    void abandon();
+
+    bool is_open() const { return _fd >= 0; }
+    uint64_t bytes_written() const { return _written + _used; }
+
+private:
+    void _write_out(const char *data, size_t size);
+    void _fail(const std::string &what);
+
+    std::string _filename;
+    std::string _temp;
+    WriteOptions _options;
+    int _fd = -1;
+    bool _direct = false;
+    char *_buffer = nullptr;
+    size_t _capacity = 0;
+    size_t _used = 0;
+    uint64_t _written = 0;
+};
+
+// Write many small files atomically, batching the syncs. Every file goes to
+//  a temp name first; writeback is started for all of them before any are
+//  waited on, then they are renamed into place and each parent directory is
+//  synced once.
+class WriteBatch {
+public:
+    explicit WriteBatch(bool durable = true) : _durable(durable) {}
+
+    void add(const std::string &filename, std::string data);
+    void add(const std::string &filename, const std::vector<char> &data);
+    void commit();
+    void commit(ThreadPool &pool);
+
+    size_t size() const { return _files.size(); }
+
+private:
+    struct Pending {
+        std::string filename;
+        std::string data;
+    };
+
+    void _commit_range(size_t begin, size_t end);
+    void _sync_dirs();
+
+    std::vector<Pending> _files;
+    bool _durable;
+};
+
 std::vector<char> ReadFile(const std::string& filename);
 std::vector<std::string> ReadFileLines(const std::string& filename);
 bool FileExists(const std::string& filename);
+bool PathExists(const std::string& path);
+FileStat StatFile(const std::string& path, bool follow_links=true);
+FileStats StatFiles(const std::vector<std::string> &paths, bool follow_links=true);
+FileStats StatFiles(const std::vector<std::string> &paths, ThreadPool &pool, bool follow_links=true);
 std::vector<std::string> ListFiles(const std::string &path, bool recurse=false);
 std::vector<std::string> ListDirs(const std::string &path, bool recurse=false);
+PathList ListFilesCompact(const std::string &path, bool recurse=false);
+PathList ListDirsCompact(const std::string &path, bool recurse=false);
+void WriteFile(const std::string& filename, const void *data, size_t size, const WriteOptions &options = WriteOptions());
+void WriteFile(const std::string& filename, std::string_view data, const WriteOptions &options = WriteOptions());
+void WriteFile(const std::string& filename, const std::vector<char> &data, const WriteOptions &options = WriteOptions());
 
 }
 
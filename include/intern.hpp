@@ -0,0 +1,97 @@
+#ifndef __libcee_INTERN_H__
+#define __libcee_INTERN_H__
+
+/**
+ *  (     (                           
+ *  )\ )  )\ )   (     (              
+ * (()/( (()/( ( )\    )\   (    (    
+ *  /(_)) /(_)))((_) (((_)  )\   )\   
+ * (_))  (_)) ((_)_  )\___ ((_) ((_)  
+ * | |   |_ _| | _ )((/ __|| __|| __| 
+ * | |__  | |  | _ \ | (__ | _| | _|  
+ * |____||___| |___/  \___||___||___| 
+ *                                             
+ * @file intern.hpp
+ * @author Benjamin Blundell - me@benjamin.computer
+ * @date 18/10/2026
+ * @brief A thread safe string interner / symbol table.
+ *
+ *  Each distinct string is stored once and given a small integer id, so
+ *  repeated tokens, extensions and path prefixes cost four bytes each and
+ *  compare and hash as integers. The characters live in arenas and never
+ *  move, so views handed out stay valid for the life of the interner.
+ *
+ *  The table is split into shards, each with its own lock, so ThreadPool
+ *  workers can intern at the same time without queueing on one mutex.
+ *
+ *  StringInterner names;
+ *  InternId a = names.intern("png");
+ *  InternId b = names.intern(GetFileExtension(path));
+ *  if (a == b) { ... }
+ *  std::cout << names.view(a);
+ *
+ */
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "arena.hpp"
+
+namespace libcee {
+
+using InternId = uint32_t;
+
+class StringInterner {
+public:
+    struct MemoryUsage {
+        size_t string_bytes = 0;    // characters stored, including terminators
+        size_t arena_bytes = 0;     // bytes reserved by the arenas
+        size_t table_bytes = 0;     // approximate size of the lookup tables
+        size_t total() const { return arena_bytes + table_bytes; }
+    };
+
+    // shard_count is rounded up to a power of two, at most 64.
+    explicit StringInterner(size_t shard_count = 16);
+
+    StringInterner(const StringInterner &) = delete;
+    StringInterner &operator=(const StringInterner &) = delete;
+
+    InternId intern(std::string_view str);
+
+    // Intern and return the stored copy. The view is nul terminated.
+    std::string_view intern_view(std::string_view str);
+
+    std::optional<InternId> find(std::string_view str) const;
+
+    // The string for an id from this interner. The view is nul terminated.
+    std::string_view view(InternId id) const;
+
+    size_t size() const;
+    MemoryUsage memory_usage() const;
+
+private:
+    // Padded so two shards' locks never share a cache line.
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        Arena arena{ 64 * 1024 };
+        std::unordered_map<std::string_view, InternId> table;
+        std::vector<std::string_view> strings;
+    };
+
+    size_t _shard_of(std::string_view str) const;
+    InternId _insert(Shard &shard, size_t shard_index, std::string_view str,
+                     std::string_view *stored);
+
+    std::vector<std::unique_ptr<Shard>> _shards;
+    uint32_t _shard_bits = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef __libcee_PATHLIST_H__
+#define __libcee_PATHLIST_H__
+
+/**
+ *  (     (                           
+ *  )\ )  )\ )   (     (              
+ * (()/( (()/( ( )\    )\   (    (    
+ *  /(_)) /(_)))((_) (((_)  )\   )\   
+ * (_))  (_)) ((_)_  )\___ ((_) ((_)  
+ * | |   |_ _| | _ )((/ __|| __|| __| 
+ * | |__  | |  | _ \ | (__ | _| | _|  
+ * |____||___| |___/  \___||___||___| 
+ *                                             
+ * @file pathlist.hpp
+ * @author Benjamin Blundell - me@benjamin.computer
+ * @date 18/10/2026
+ * @brief A compact list of paths that share directory prefixes.
+ *
+ *  Rather than a full string per path, each directory and entry is stored
+ *  once as (parent, name) with all the names packed into one buffer. Full
+ *  paths are only built when asked for. For a big recursive listing this
+ *  is several times smaller than a std::vector<std::string>.
+ *
+ *  PathList files = ListFilesCompact("/data", true);
+ *  std::string buffer;
+ *  for (size_t i = 0; i < files.size(); ++i) {
+ *      files.path(i, buffer);
+ *      if (GetFileExtensionView(files.name(i)) == "png") { ... }
+ *  }
+ *
+ */
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace libcee {
+
+class PathList {
+public:
+    // The node for the base path given to the constructor.
+    static constexpr uint32_t ROOT = 0;
+
+    explicit PathList(std::string_view root = "");
+
+    // Add a directory that entries can hang off. Returns its node id.
+    //  If listed is true it is also added as an entry.
+    uint32_t add_dir(uint32_t parent, std::string_view name, bool listed = false);
+
+    // Add an entry (usually a file) inside the directory node parent.
+    void add(uint32_t parent, std::string_view name);
+
+    size_t size() const { return _entries.size(); }
+    bool empty() const { return _entries.empty(); }
+
+    std::string path(size_t i) const;
+    void path(size_t i, std::string &out) const;
+    std::string operator[](size_t i) const { return path(i); }
+
+    std::string_view name(size_t i) const { return _name_of(_entries[i]); }
+    uint32_t parent(size_t i) const { return _entries[i].parent; }
+    std::string dir_path(uint32_t node) const;
+
+    std::vector<std::string> to_vector() const;
+
+    // Bytes held by the list, counting reserved capacity.
+    size_t memory_usage() const;
+    void shrink_to_fit();
+
+    class const_iterator {
+    public:
+        const_iterator(const PathList *list, size_t i) : _list(list), _i(i) {}
+        std::string operator*() const { return _list->path(_i); }
+        const_iterator &operator++() { ++_i; return *this; }
+        bool operator==(const const_iterator &other) const { return _i == other._i; }
+        bool operator!=(const const_iterator &other) const { return _i != other._i; }
+    private:
+        const PathList *_list;
+        size_t _i;
+    };
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, _entries.size()); }
+
+private:
+    struct Node {
+        uint32_t parent;
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    std::string_view _name_of(const Node &node) const {
+        return std::string_view(_names.data() + node.offset, node.length);
+    }
+    Node _store(uint32_t parent, std::string_view name);
+    void _build(const Node &node, std::string &out) const;
+
+    std::vector<char> _names;
+    std::vector<Node> _dirs;
+    std::vector<Node> _entries;
+};
+
+}
+
+#endif
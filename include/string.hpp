@@ -21,6 +21,7 @@
 #include <vector>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <iomanip>
 #include <stdexcept>
@@ -43,13 +44,30 @@
 #include <glm/mat4x4.hpp>
 #endif
 
+#include "stringbuilder.hpp"
+
 
 namespace libcee {
 
 template<class T> inline std::string ToString(const T& t) {
-  std::ostringstream stream;
-  stream << t;
-  return stream.str();
+  // Numbers and strings skip the stringstream; chars and bools still print
+  // the way an ostream would, so they go the slow way.
+  if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char> &&
+                !std::is_same_v<T, signed char> && !std::is_same_v<T, unsigned char>) {
+    StringBuilder b;
+    b.append_int(t);
+    return b.str();
+  } else if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
+    StringBuilder b;
+    b.append_float(t);
+    return b.str();
+  } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+    return std::string(std::string_view(t));
+  } else {
+    std::ostringstream stream;
+    stream << t;
+    return stream.str();
+  }
 }
 
 template<class T> inline T FromString(const std::string& s) {
@@ -78,6 +96,20 @@ static inline std::string GetFileExtension(const std::string &input) {
   return input.substr(input.find_last_of(".") + 1) ;
 }
 
+// string_view versions of the above. No allocation; the views point into input.
+
+static inline std::string_view FilenameFromPathView(std::string_view input) {
+  return input.substr(input.find_last_of("\\/")+1);
+}
+
+static inline std::string_view PathFromPathView(std::string_view input) {
+  return input.substr(0, input.find_last_of("\\/"));
+}
+
+static inline std::string_view GetFileExtensionView(std::string_view input) {
+  return input.substr(input.find_last_of(".") + 1);
+}
+
 static inline bool IsAsciiString(std::string &input) {
   for(std::string::iterator it = input.begin(); it != input.end(); ++it) {
     int c = static_cast<int>(*it);
@@ -105,9 +137,9 @@ inline std::string ToPrecision(float num, int n) {
   float magnitude = pow(10., power);
   long shifted = ::round(num*magnitude);
 
-  std::ostringstream oss;
-  oss << shifted/magnitude;
-  return oss.str();
+  StringBuilder b;
+  b.append_float(shifted/magnitude);
+  return b.str();
 }
 
 inline std::string ToPrecision(double num, int n) {
@@ -121,9 +153,9 @@ inline std::string ToPrecision(double num, int n) {
   double magnitude = pow(10., power);
   long shifted = ::round(num*magnitude);
 
-  std::ostringstream oss;
-  oss << shifted/magnitude;
-  return oss.str();
+  StringBuilder b;
+  b.append_float(shifted/magnitude);
+  return b.str();
 }
 
 
@@ -233,9 +265,9 @@ static inline bool StringBeginsWith(const std::string& input, const std::string&
  * Integer to string but with leading zeroes.
  */
 static inline std::string IntToStringLeadingZeroes(int i, int num_zeroes) {
-  std::stringstream s;
-  s << std::setw(num_zeroes) << std::setfill('0') << i;
-  return s.str();
+  StringBuilder b;
+  b.append_int(i, num_zeroes, '0');
+  return b.str();
 }
 
 /**
@@ -268,18 +300,20 @@ static inline std::string StringRemove(const std::string s, const std::string r)
 */
 
 std::string inline TextFileRead(std::string filename) {
-  std::string line;
-  std::string rval;
+  StringBuilder rval;
   std::ifstream myfile (filename.c_str());
   if (myfile.is_open()){
-    while ( myfile.good() ) {
-      getline (myfile,line);
-      rval += line +"\n";
+    // Read in big blocks rather than by line. The old line loop always left
+    // one extra newline on the end, so keep doing that.
+    char block[16384];
+    while (myfile.read(block, sizeof(block)) || myfile.gcount() > 0) {
+      rval.append(block, (size_t)myfile.gcount());
     }
+    rval.append('\n');
     myfile.close();
   } else 
     std::cerr << "SEBURO - Unable to open text file " << filename << std::endl;
-  return rval;
+  return rval.str();
 }
 
 /*
@@ -338,35 +372,29 @@ static inline std::string StringReplace(std::string& str, const std::string& fro
 */
 
 static inline std::string MatrixToString(const glm::mat4 &mat){
-  std::stringstream s;
-  int i,j;
-  for (j=0; j<4; ++j){
-    for (i=0; i<4; ++i){
-      s << std::setprecision(2) << std::setfill('0') << std::setw(5) << mat[i][j] << " ";
-    }
-    s << std::endl;
-  }
+  StringBuilder s;
+  s.append(mat);
   return s.str();
 }
 
 /// return a string from a GLM Vector 2
 static inline std::string VecToString (const glm::vec2 &vec) {
-  std::stringstream s;
-  s << vec.x << ", " << vec.y;
+  StringBuilder s;
+  s.append(vec);
   return s.str();
 }
 
 /// return a string from a GLM Vector 3
 static inline std::string VecToString (const glm::vec3 &vec) {
-  std::stringstream s;
-  s << vec.x << ", " << vec.y << ", " << vec.z;
+  StringBuilder s;
+  s.append(vec);
   return s.str();
 }
 
 /// return a string from a GLM Vector 4
 static inline std::string VecToString (const glm::vec4 &vec) {
-  std::stringstream s;
-  s << vec.x << ", " << vec.y << ", " << vec.z << ", " << vec.w;
+  StringBuilder s;
+  s.append(vec);
   return s.str();
 }
 #endif
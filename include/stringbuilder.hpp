@@ -0,0 +1,214 @@
+#ifndef __libcee_STRINGBUILDER_H__
+#define __libcee_STRINGBUILDER_H__
+
+/**
+ *  (     (                           
+ *  )\ )  )\ )   (     (              
+ * (()/( (()/( ( )\    )\   (    (    
+ *  /(_)) /(_)))((_) (((_)  )\   )\   
+ * (_))  (_)) ((_)_  )\___ ((_) ((_)  
+ * | |   |_ _| | _ )((/ __|| __|| __| 
+ * | |__  | |  | _ \ | (__ | _| | _|  
+ * |____||___| |___/  \___||___||___| 
+ *                                             
+ * @file stringbuilder.hpp
+ * @author Benjamin Blundell - me@benjamin.computer
+ * @date 18/10/2026
+ * @brief An append-only string buffer that formats without iostreams.
+ *
+ *  The first INLINE_SIZE bytes live inside the object, so short strings
+ *  never touch the heap. Numbers are formatted with std::to_chars and padded
+ *  the same way std::setw / std::setfill would.
+ *
+ *  StringBuilder b;
+ *  b.append("frame ").append_int(frame, 5, '0').append(" took ");
+ *  b.append_float(ms, 3).append("ms\n");
+ *  std::cout << b.view();
+ *
+ */
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#ifdef _USE_GLM
+#include <glm/glm.hpp>
+#include <glm/mat4x4.hpp>
+#endif
+
+namespace libcee {
+
+class StringBuilder {
+public:
+    static constexpr size_t INLINE_SIZE = 256;
+
+    StringBuilder() = default;
+    StringBuilder(const StringBuilder &other) { append(other.view()); }
+    StringBuilder(StringBuilder &&other) noexcept { _take(other); }
+    StringBuilder &operator=(const StringBuilder &other) {
+        if (this != &other) { clear(); append(other.view()); }
+        return *this;
+    }
+    StringBuilder &operator=(StringBuilder &&other) noexcept {
+        if (this != &other) { _release(); _take(other); }
+        return *this;
+    }
+    ~StringBuilder() { _release(); }
+
+    StringBuilder &append(std::string_view str) {
+        char *out = _grow(str.size());
+        if (!str.empty()) { std::memcpy(out, str.data(), str.size()); }
+        return *this;
+    }
+
+    StringBuilder &append(const char *str, size_t length) {
+        return append(std::string_view(str, length));
+    }
+
+    StringBuilder &append(char c) {
+        *_grow(1) = c;
+        return *this;
+    }
+
+    // Other numbers would quietly convert to a char, so append(42) gives
+    //  "*". Use append_int or append_float for those.
+    template <typename T, std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, char>, int> = 0>
+    StringBuilder &append(T) = delete;
+
+    StringBuilder &append(size_t count, char c) {
+        std::memset(_grow(count), c, count);
+        return *this;
+    }
+
+    /**
+     * Append an integer, right aligned in width characters of fill, as
+     * std::setw(width) << std::setfill(fill) << value would.
+     */
+    template <typename T>
+    StringBuilder &append_int(T value, int width = 0, char fill = ' ') {
+        static_assert(std::is_integral_v<T>, "append_int needs an integer");
+        char buffer[24];
+        auto res = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        return _append_padded(buffer, res.ptr - buffer, width, fill);
+    }
+
+    /**
+     * Append a float with precision significant digits, formatted as an
+     * ostream with std::setprecision(precision) would (printf's %g).
+     */
+    StringBuilder &append_float(double value, int precision = 6, int width = 0, char fill = ' ') {
+        char buffer[64];
+        size_t length;
+#if defined(__cpp_lib_to_chars)
+        auto res = std::to_chars(buffer, buffer + sizeof(buffer), value,
+                                 std::chars_format::general, precision);
+        length = res.ptr - buffer;
+#else
+        length = (size_t)std::snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+#endif
+        return _append_padded(buffer, length, width, fill);
+    }
+
+#ifdef _USE_GLM
+    // Vectors are written as "x, y, z" to match VecToString.
+    StringBuilder &append(const glm::vec2 &vec) {
+        return append_float(vec.x).append(", ").append_float(vec.y);
+    }
+
+    StringBuilder &append(const glm::vec3 &vec) {
+        return append_float(vec.x).append(", ").append_float(vec.y).append(", ").append_float(vec.z);
+    }
+
+    StringBuilder &append(const glm::vec4 &vec) {
+        append_float(vec.x).append(", ").append_float(vec.y).append(", ");
+        return append_float(vec.z).append(", ").append_float(vec.w);
+    }
+
+    // One row per line, to match MatrixToString.
+    StringBuilder &append(const glm::mat4 &mat) {
+        for (int j = 0; j < 4; ++j) {
+            for (int i = 0; i < 4; ++i) {
+                append_float(mat[i][j], 2, 5, '0').append(' ');
+            }
+            append('\n');
+        }
+        return *this;
+    }
+#endif
+
+    void reserve(size_t capacity) {
+        if (capacity > _capacity) { _reallocate(capacity); }
+    }
+
+    void clear() { _size = 0; }
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    const char *data() const { return _data; }
+    std::string_view view() const { return std::string_view(_data, _size); }
+    std::string str() const { return std::string(_data, _size); }
+
+private:
+    StringBuilder &_append_padded(const char *text, size_t length, int width, char fill) {
+        size_t pad = width > 0 && (size_t)width > length ? (size_t)width - length : 0;
+        char *out = _grow(pad + length);
+        std::memset(out, fill, pad);
+        std::memcpy(out + pad, text, length);
+        return *this;
+    }
+
+    // Make room for count more bytes and return where they go.
+    char *_grow(size_t count) {
+        if (_size + count > _capacity) {
+            _reallocate(std::max(_size + count, _capacity * 2));
+        }
+        char *out = _data + _size;
+        _size += count;
+        return out;
+    }
+
+    void _reallocate(size_t capacity) {
+        char *data = static_cast<char *>(std::malloc(capacity));
+        if (data == nullptr) { throw std::bad_alloc(); }
+        std::memcpy(data, _data, _size);
+        _release();
+        _data = data;
+        _capacity = capacity;
+    }
+
+    void _release() {
+        if (_data != _inline) { std::free(_data); }
+        _data = _inline;
+        _capacity = INLINE_SIZE;
+    }
+
+    void _take(StringBuilder &other) {
+        if (other._data == other._inline) {
+            std::memcpy(_inline, other._inline, other._size);
+            _data = _inline;
+            _capacity = INLINE_SIZE;
+        } else {
+            _data = other._data;
+            _capacity = other._capacity;
+            other._data = other._inline;
+            other._capacity = INLINE_SIZE;
+        }
+        _size = other._size;
+        other._size = 0;
+    }
+
+    char _inline[INLINE_SIZE];
+    char *_data = _inline;
+    size_t _size = 0;
+    size_t _capacity = INLINE_SIZE;
+};
+
+}
+
+#endif
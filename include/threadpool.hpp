@@ -26,6 +26,27 @@
  *  futures.push_back(pool.execute( [] () {} ));
  *  for (auto &fut : futures) { fut.get(); }
  * 
+ *  Workers can be pinned and named by passing ThreadPoolOptions:
+ * 
+ *  ThreadPoolOptions options;
+ *  options.affinity = ThreadAffinity::NumaNode;
+ *  options.name = "loader";
+ *  ThreadPool pool{ 16, options };
+ * 
+ *  An elastic pool starts with thread_count workers, adds more (up to
+ *  max_threads) while tasks are queueing faster than they are taken, and
+ *  retires the extras after idle_timeout without work. Setting
+ *  spin_iterations makes idle workers poll briefly before they sleep, which
+ *  saves a futex wake and a context switch on bursts of short tasks:
+ * 
+ *  options.elastic = true;
+ *  options.max_threads = 32;
+ *  options.spin_iterations = 2000;
+ * 
+ *  Inside a task, ThreadPool::current_worker() gives the worker index and
+ *  NUMA node, and ThreadPool::scratch() a thread-local Arena whose memory
+ *  is first touched (and so placed) on that worker's node.
+ * 
  */
 
 #include <vector>
@@ -36,58 +57,179 @@
 #include <mutex>
 #include <condition_variable>
 #include <type_traits> //invoke_result
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <fstream>
+#include <cstdlib>
+#include <algorithm>
+#include <cstdint>
+#include <system_error>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+#include "arena.hpp"
 
 
 namespace libcee {
 
+/**
+ * Parse a Linux cpulist string such as "0-3,8,10-11"
+ * 
+ * @param list - the cpulist
+ * 
+ * @return vector of cpu ids
+ */
+inline std::vector<int> ParseCpuList(const std::string &list) {
+    std::vector<int> cpus;
+    size_t pos = 0;
+    while (pos < list.size()) {
+        size_t end = list.find(',', pos);
+        if (end == std::string::npos) { end = list.size(); }
+        std::string range = list.substr(pos, end - pos);
+        size_t dash = range.find('-');
+        if (!range.empty() && range[0] != '\n') {
+            int first = std::atoi(range.c_str());
+            int last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+            for (int c = first; c <= last; ++c) { cpus.push_back(c); }
+        }
+        pos = end + 1;
+    }
+    return cpus;
+}
+
+/**
+ * The cpus we are allowed to run on, grouped by NUMA node. Cpus outside our
+ * affinity mask (taskset, cgroups) are left out. Machines without NUMA info
+ * in sysfs come back as a single node.
+ * 
+ * @return vector indexed by node of vector of cpu ids
+ */
+inline std::vector<std::vector<int>> NumaNodeCpus() {
+    std::vector<std::vector<int>> nodes;
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool have_mask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+    auto usable = [&](int c) { return !have_mask || (c < CPU_SETSIZE && CPU_ISSET(c, &allowed)); };
+
+    //node ids can have gaps, so walk the ones listed as online. A missing
+    //  id is left as an empty node.
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string online_list;
+    if (online.is_open()) { std::getline(online, online_list); }
+    for (int node : ParseCpuList(online_list)) {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!file.is_open() || node < 0) { continue; }
+        std::string list;
+        std::getline(file, list);
+        if ((size_t)node >= nodes.size()) { nodes.resize(node + 1); }
+        for (int c : ParseCpuList(list)) {
+            if (usable(c)) { nodes[node].push_back(c); }
+        }
+    }
+
+    if (nodes.empty()) {
+        std::vector<int> cpus;
+        for (int c = 0; c < CPU_SETSIZE; ++c) {
+            if (have_mask ? CPU_ISSET(c, &allowed) : c < (int)std::thread::hardware_concurrency()) {
+                cpus.push_back(c);
+            }
+        }
+        nodes.push_back(cpus);
+    }
+#else
+    std::vector<int> cpus;
+    for (unsigned int c = 0; c < std::thread::hardware_concurrency(); ++c) { cpus.push_back(c); }
+    nodes.push_back(cpus);
+#endif
+    return nodes;
+}
+
+enum class ThreadAffinity {
+    None,       // let the scheduler place workers anywhere
+    Core,       // one worker per cpu, filling a node before moving to the next
+    NumaNode    // workers spread round-robin across nodes, free within a node
+};
+
+struct ThreadPoolOptions {
+    ThreadAffinity affinity = ThreadAffinity::None;
+    std::string name;       // workers are named "<name>-<index>", cut to 15 chars
+    size_t scratch_block_size = Arena::DEFAULT_BLOCK_SIZE;
+
+    // Elastic pools keep at least thread_count workers and at most
+    //  max_threads (0 means hardware_concurrency).
+    //  A worker is added when the queue has stayed longer than the idle
+    //  workers can take for a whole backlog_window, one per window, or
+    //  straight away if there are no workers at all (thread_count may be 0).
+    bool elastic = false;
+    size_t max_threads = 0;
+    std::chrono::milliseconds idle_timeout{ 2000 };
+    std::chrono::milliseconds backlog_window{ 2 };
+
+    // Times an idle worker polls the queue, backing off, before it sleeps.
+    //  0 sleeps straight away.
+    unsigned int spin_iterations = 0;
+};
+
+// What a task can learn about the worker running it.
+struct WorkerContext {
+    size_t index = 0;
+    int numa_node = -1;     // -1 if the worker is not bound to a node
+    int cpu = -1;           // -1 if the worker is not bound to a single cpu
+};
+
 class ThreadPool {
 public:
-    ThreadPool(size_t thread_count) {
+    ThreadPool(size_t thread_count) : ThreadPool(thread_count, ThreadPoolOptions()) {}
+
+    ThreadPool(size_t thread_count, const ThreadPoolOptions &options) : _options(options) {
+        if (_options.affinity != ThreadAffinity::None) { _nodes = NumaNodeCpus(); }
+
+        _min_threads = thread_count;
+        _max_threads = thread_count;
+        if (_options.elastic) {
+            size_t max = _options.max_threads;
+            if (max == 0) { max = std::thread::hardware_concurrency(); }
+            _max_threads = std::max({ thread_count, max, size_t(1) });
+        }
+
+        //every slot exists up front so threads can be started into them
+        //  without the lock; slot 0 is handed out first.
+        _threads.resize(_max_threads);
+        for (size_t i = _max_threads; i > 0; --i) { _free_slots.push_back(i - 1); }
+
         for (size_t i = 0; i < thread_count; ++i) {
-        
-        //start waiting threads. Workers listen for changes through
-        //  the thread_pool member condition_variable
-            _threads.emplace_back(
-                std::thread(
-                    [&]() {
-                    std::unique_lock<std::mutex> queue_lock(_task_mutex, std::defer_lock);
-
-                        while (true) {
-                            queue_lock.lock();
-                            _task_cv.wait(
-                                queue_lock, 
-                                [&]() -> bool { return !_tasks.empty() || _stop_threads; }
-                            );
-
-                            //used by dtor to stop all threads without having to
-                            //  unceremoniously stop tasks. The tasks must all be finished,
-                            //  lest we break a promise and risk a future object throwing
-                            //  an exception.
-                            if (_stop_threads && _tasks.empty()) return;
-
-                            //to initialize temp_task, we must move the unique_ptr from the
-                            //  queue to the local stack. Since a unique_ptr cannot be copied
-                            //  (obviously), it must be explicitly moved. This transfers
-                            //  ownership of the pointed-to object to *this, as specified in
-                            //  20.11.1.2.1 [unique.ptr.single.ctor].
-                            auto temp_task = std::move(_tasks.front());
-                            
-                            _tasks.pop();
-                            queue_lock.unlock();
-
-                            (*temp_task)();
-                        }
-                    }
-                )
-            );
+            std::unique_lock<std::mutex> queue_lock(_task_mutex);
+            size_t slot = _reserve_slot();
+            queue_lock.unlock();
+            _start(slot);
         }
+
+        if (_options.elastic) { _monitor = std::thread([this]() { _monitor_loop(); }); }
     }
     ~ThreadPool() {
-          _stop_threads = true;
+        //set under the lock so a worker between checking the predicate and
+        //  sleeping can't miss it. No slot is reserved once it is set, but
+        //  one already reserved may still be starting.
+        std::unique_lock<std::mutex> queue_lock(_task_mutex);
+        _stop_threads = true;
+        _monitor_cv.notify_all();
+        _task_cv.wait(queue_lock, [this]() { return _starting == 0; });
+        queue_lock.unlock();
         _task_cv.notify_all();
 
+        if (_monitor.joinable()) { _monitor.join(); }
+
+        //nothing touches _threads now, so it is safe to walk without the
+        //  lock. Retired threads still need joining.
         for (std::thread &thread : _threads) {
-            thread.join();
+            if (thread.joinable()) { thread.join(); }
         }
     }
     
@@ -99,8 +241,292 @@ public:
     //F must be Callable, and invoking F with ...Args must be well-formed.
     template <typename F, typename ...Args>
     auto execute(F, Args&&...);
+
+    //fire and forget: F must be Callable with no arguments. No future is made,
+    //  so this is cheaper than execute when nobody waits on the result.
+    template <typename F>
+    void post(F &&function);
+
+    //the number of live workers. Elastic pools change this as they go.
+    size_t size() const { return _live.load(std::memory_order_relaxed); }
+
+    //the most workers there can ever be. Worker indices are always below
+    //  this, so it is the size for anything indexed by worker.
+    size_t max_size() const { return _max_threads; }
+
+    //the context of the pool worker calling this, or nullptr if the caller is
+    //  not a pool worker.
+    static const WorkerContext *current_worker() { return _current_worker; }
+
+    //per-thread scratch memory. On a pinned worker the pages land on its own
+    //  node. Reset it at the end of a task if the memory is not kept.
+    static Arena &scratch() {
+        if (_scratch == nullptr) {
+            thread_local Arena arena;
+            return arena;
+        }
+        return *_scratch;
+    }
     
 private:
+    //choose the cpus for worker i and record where it will live.
+    static std::vector<int> _placement(const std::vector<std::vector<int>> &nodes,
+                                       ThreadAffinity affinity, WorkerContext &context) {
+        std::vector<size_t> populated;
+        std::vector<int> all;
+        for (size_t n = 0; n < nodes.size(); ++n) {
+            if (nodes[n].empty()) { continue; }
+            populated.push_back(n);
+            all.insert(all.end(), nodes[n].begin(), nodes[n].end());
+        }
+        if (populated.empty()) { return {}; }
+
+        if (affinity == ThreadAffinity::Core) {
+            //walk the cpus node by node so neighbouring workers share a node.
+            int cpu = all[context.index % all.size()];
+            for (size_t n : populated) {
+                if (std::find(nodes[n].begin(), nodes[n].end(), cpu) != nodes[n].end()) {
+                    context.numa_node = static_cast<int>(n);
+                }
+            }
+            context.cpu = cpu;
+            return { cpu };
+        }
+
+        if (affinity == ThreadAffinity::NumaNode) {
+            size_t node = populated[context.index % populated.size()];
+            context.numa_node = static_cast<int>(node);
+            return nodes[node];
+        }
+
+        return {};
+    }
+
+    void _setup_worker(const WorkerContext &context, const std::vector<int> &cpus) {
+#ifdef __linux__
+        if (!cpus.empty()) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int c : cpus) {
+                if (c < CPU_SETSIZE) { CPU_SET(c, &set); }
+            }
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        }
+        if (!_options.name.empty()) {
+            //linux allows 15 chars, so trim the prefix rather than the index.
+            std::string suffix = "-" + std::to_string(context.index);
+            std::string name = _options.name.substr(0, 15 - suffix.size()) + suffix;
+            pthread_setname_np(pthread_self(), name.c_str());
+        }
+#else
+        (void)cpus;
+#endif
+        //the arena is created here, after pinning, so its blocks are first
+        //  touched from the right node.
+        thread_local WorkerContext worker_context;
+        thread_local Arena arena(_options.scratch_block_size);
+        worker_context = context;
+        _current_worker = &worker_context;
+        _scratch = &arena;
+    }
+
+    static constexpr size_t NO_SLOT = SIZE_MAX;
+
+    //claim a free slot for a new worker. Must be called with _task_mutex
+    //  held; the thread itself is started by _start, without the lock.
+    size_t _reserve_slot() {
+        size_t slot = _free_slots.back();
+        _free_slots.pop_back();
+        _live++;
+        _starting++;
+        return slot;
+    }
+
+    //join whatever last ran in slot and start a worker there. The slot is
+    //  ours alone until the worker retires, so no lock is needed.
+    void _start(size_t slot) {
+        if (_threads[slot].joinable()) { _threads[slot].join(); }
+
+        WorkerContext context;
+        context.index = slot;
+        std::vector<int> cpus = _placement(_nodes, _options.affinity, context);
+
+        try {
+            //start waiting threads. Workers listen for changes through
+            //  the thread_pool member condition_variable
+            _threads[slot] = std::thread(
+                [this, context, cpus]() {
+                    _setup_worker(context, cpus);
+                    _worker_loop(context.index);
+                }
+            );
+        } catch (...) {
+            std::unique_lock<std::mutex> queue_lock(_task_mutex);
+            _live--;
+            _free_slots.push_back(slot);
+            _starting--;
+            queue_lock.unlock();
+            _task_cv.notify_all();
+            throw;
+        }
+
+        std::unique_lock<std::mutex> queue_lock(_task_mutex);
+        _starting--;
+        bool stopping = _stop_threads;
+        queue_lock.unlock();
+        if (stopping) { _task_cv.notify_all(); }
+    }
+
+    //grow an elastic pool off the submit path. Failing to start a thread
+    //  is not fatal; the queued work still runs on the workers we have.
+    void _grow(size_t slot) {
+        try {
+            _start(slot);
+        } catch (const std::system_error &) {
+        }
+    }
+
+    //called with _task_mutex held whenever the queue changes. An elastic pool
+    //  only grows once the queue has been longer than the idle workers
+    //  (sleeping or spinning) for a whole backlog_window, so a short burst
+    //  that they soon clear adds nothing. Returns a reserved slot or NO_SLOT.
+    size_t _check_backlog() {
+        if (!_options.elastic || _stop_threads || _free_slots.empty()) { return NO_SLOT; }
+
+        //nobody at all to run the queue: don't wait out a window for it.
+        if (_live == 0 && !_tasks.empty()) { return _reserve_slot(); }
+
+        size_t idle = _sleeping + _spinning.load(std::memory_order_relaxed);
+        if (_tasks.size() <= idle) {
+            _backlog = false;
+            return NO_SLOT;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (!_backlog) {
+            _backlog = true;
+            _backlog_since = now;
+            //the workers may all be busy, so nothing else will look again.
+            _monitor_cv.notify_one();
+            return NO_SLOT;
+        }
+        if (now - _backlog_since < _options.backlog_window) { return NO_SLOT; }
+
+        //start the window again, so the pool grows by at most one per window.
+        _backlog_since = now;
+        return _reserve_slot();
+    }
+
+    //elastic pools only. Looks at an open backlog window again once it has
+    //  run its length, so a queue that no worker is free to take still
+    //  grows the pool. Sleeps while there is no backlog or no free slot.
+    void _monitor_loop() {
+        std::unique_lock<std::mutex> queue_lock(_task_mutex);
+        while (!_stop_threads) {
+            if (!_backlog || _free_slots.empty()) {
+                _monitor_cv.wait(queue_lock);
+                continue;
+            }
+            auto deadline = _backlog_since + _options.backlog_window;
+            if (std::chrono::steady_clock::now() < deadline) {
+                _monitor_cv.wait_until(queue_lock, deadline);
+                continue;
+            }
+
+            size_t slot = _check_backlog();
+            if (slot != NO_SLOT) {
+                queue_lock.unlock();
+                _grow(slot);
+                queue_lock.lock();
+            }
+        }
+    }
+
+    static void _cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+        _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        asm volatile("yield");
+#endif
+    }
+
+    //poll for work before going to sleep. Starts with a few pause
+    //  instructions, doubling up to 64 per round, then yields the cpu.
+    void _spin_for_work() {
+        unsigned int pauses = 1;
+        for (unsigned int i = 0; i < _options.spin_iterations; ++i) {
+            if (_pending.load(std::memory_order_acquire) > 0) { return; }
+            if (pauses <= 64) {
+                for (unsigned int p = 0; p < pauses; ++p) { _cpu_relax(); }
+                pauses *= 2;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void _worker_loop(size_t slot) {
+        std::unique_lock<std::mutex> queue_lock(_task_mutex, std::defer_lock);
+        auto ready = [&]() -> bool { return !_tasks.empty() || _stop_threads; };
+
+        while (true) {
+            if (_options.spin_iterations > 0) {
+                _spinning.fetch_add(1, std::memory_order_relaxed);
+                _spin_for_work();
+                _spinning.fetch_sub(1, std::memory_order_relaxed);
+            }
+            queue_lock.lock();
+
+            if (!ready()) {
+                _sleeping++;
+                bool woken = true;
+                if (_options.elastic) {
+                    woken = _task_cv.wait_for(queue_lock, _options.idle_timeout, ready);
+                } else {
+                    _task_cv.wait(queue_lock, ready);
+                }
+                _sleeping--;
+
+                //idle for a whole timeout: hand the slot back if we are
+                //  above the minimum. The next _start or the dtor joins us.
+                if (!woken) {
+                    if (_live > _min_threads) {
+                        _live--;
+                        _free_slots.push_back(slot);
+                        _monitor_cv.notify_one();
+                        return;
+                    }
+                    queue_lock.unlock();
+                    continue;
+                }
+            }
+
+            //used by dtor to stop all threads without having to
+            //  unceremoniously stop tasks. The tasks must all be finished,
+            //  lest we break a promise and risk a future object throwing
+            //  an exception.
+            if (_stop_threads && _tasks.empty()) return;
+
+            //to initialize temp_task, we must move the unique_ptr from the
+            //  queue to the local stack. Since a unique_ptr cannot be copied
+            //  (obviously), it must be explicitly moved. This transfers
+            //  ownership of the pointed-to object to *this, as specified in
+            //  20.11.1.2.1 [unique.ptr.single.ctor].
+            auto temp_task = std::move(_tasks.front());
+            
+            _tasks.pop();
+            _pending.fetch_sub(1, std::memory_order_relaxed);
+            size_t grow_slot = _check_backlog();
+            queue_lock.unlock();
+
+            if (grow_slot != NO_SLOT) { _grow(grow_slot); }
+            (*temp_task)();
+        }
+    }
+
+    inline static thread_local const WorkerContext *_current_worker = nullptr;
+    inline static thread_local Arena *_scratch = nullptr;
+
     //_task_container_base and _task_container exist simply as a wrapper around a 
     //  MoveConstructible - but not CopyConstructible - Callable object. Since an
     //  std::function requires a given Callable to be CopyConstructible, we cannot
@@ -149,33 +575,62 @@ private:
         );
     }
     
+    //queue a task and wake a sleeper if there is one. An elastic pool may
+    //  also grow, see _check_backlog.
+    void _enqueue(std::unique_ptr<_task_container_base> task) {
+        std::unique_lock<std::mutex> queue_lock(_task_mutex);
+        _tasks.emplace(std::move(task));
+        _pending.fetch_add(1, std::memory_order_release);
+        size_t grow_slot = _check_backlog();
+        bool wake = _sleeping > 0;
+        queue_lock.unlock();
+
+        if (wake) { _task_cv.notify_one(); }
+        if (grow_slot != NO_SLOT) { _grow(grow_slot); }
+    }
+
     std::vector<std::thread> _threads;
     std::queue<std::unique_ptr<_task_container_base>> _tasks;
     std::mutex _task_mutex;
     std::condition_variable _task_cv;
+    std::condition_variable _monitor_cv;
+    std::thread _monitor;
     bool _stop_threads = false;
+    ThreadPoolOptions _options;
+    std::vector<std::vector<int>> _nodes;
+    std::vector<size_t> _free_slots;        // unused slots, or ones whose threads have exited
+    std::atomic<size_t> _pending{ 0 };      // _tasks.size(), readable without the lock
+    std::atomic<size_t> _live{ 0 };
+    std::atomic<size_t> _spinning{ 0 };     // workers polling in _spin_for_work
+    size_t _sleeping = 0;
+    size_t _starting = 0;                   // reserved slots whose threads are not started yet
+    bool _backlog = false;
+    std::chrono::steady_clock::time_point _backlog_since;
+    size_t _min_threads = 0;
+    size_t _max_threads = 0;
 };
 
 template <typename F, typename ...Args>
 auto ThreadPool::execute(F function, Args &&...args) {
-    std::unique_lock<std::mutex> queue_lock(_task_mutex, std::defer_lock);
     std::packaged_task<std::invoke_result_t<F, Args...>()> task_pkg(
         std::bind(function, args...)
     );
     std::future<std::invoke_result_t<F, Args...>> future = task_pkg.get_future();
 
-    queue_lock.lock();
     //this lambda move-captures the packaged_task declared above. Since the packaged_task
     //  type is not CopyConstructible, the function is not CopyConstructible either -
     //  hence the need for a _task_container to wrap around it.
-    _tasks.emplace(
+    _enqueue(
         allocate_task_container([task(std::move(task_pkg))]() mutable { task(); })
     );
-    queue_lock.unlock();
 
-    _task_cv.notify_one();
+    return future;
+}
 
-    return std::move(future);
+template <typename F>
+void ThreadPool::post(F &&function) {
+    //decay so an lvalue is copied into the container rather than referenced.
+    _enqueue(allocate_task_container(std::decay_t<F>(std::forward<F>(function))));
 }
 
 }
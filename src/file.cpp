@@ -16,6 +16,27 @@
  */
 
 #include "file.hpp"
+#include "threadpool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <future>
+#include <set>
+#include <string_view>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#else
+#include <io.h>
+#include <fcntl.h>
+#include <process.h>
+#include <sys/stat.h>
+#endif
 
 namespace libcee {
 
@@ -76,8 +97,270 @@ std::vector<std::string> ReadFileLines(const std::string& filename) {
  */
 
 bool FileExists(const std::string& filename) {
+#ifdef _WIN32
     std::ifstream ifile(filename.c_str());
     return (bool)ifile;
+#else
+    // Same answer as opening it for reading, without the open or the buffers.
+    return access(filename.c_str(), R_OK) == 0;
+#endif
+}
+
+/**
+ * Check if anything exists at this path, readable or not
+ * 
+ * @param path - the path
+ * 
+ * @return bool
+ */
+
+bool PathExists(const std::string& path) {
+#ifdef _WIN32
+    std::error_code ec;
+    return std::filesystem::exists(path, ec);
+#else
+    return access(path.c_str(), F_OK) == 0;
+#endif
+}
+
+#ifndef _WIN32
+// Stat name relative to the directory dirfd (or AT_FDCWD). statx with
+//  AT_STATX_DONT_SYNC lets network filesystems answer from cache.
+static FileStat StatAt(int dirfd, const char *name, bool follow_links) {
+    FileStat res;
+    mode_t mode;
+    int flags = follow_links ? 0 : AT_SYMLINK_NOFOLLOW;
+#if defined(__linux__) && defined(STATX_TYPE)
+    struct statx sx;
+    if (statx(dirfd, name, flags | AT_STATX_DONT_SYNC, STATX_TYPE | STATX_SIZE | STATX_MTIME, &sx) != 0) {
+        return res;
+    }
+    mode = sx.stx_mode;
+    res.size = sx.stx_size;
+    res.mtime_ns = (int64_t)sx.stx_mtime.tv_sec * 1000000000 + sx.stx_mtime.tv_nsec;
+#else
+    struct stat st;
+    if (fstatat(dirfd, name, &st, flags) != 0) {
+        return res;
+    }
+    mode = st.st_mode;
+    res.size = st.st_size;
+#ifdef __APPLE__
+    const struct timespec &mtime = st.st_mtimespec;
+#else
+    const struct timespec &mtime = st.st_mtim;
+#endif
+    res.mtime_ns = (int64_t)mtime.tv_sec * 1000000000 + mtime.tv_nsec;
+#endif
+    if (S_ISREG(mode)) { res.type = FileType::Regular; }
+    else if (S_ISDIR(mode)) { res.type = FileType::Directory; }
+    else if (S_ISLNK(mode)) { res.type = FileType::Symlink; }
+    else { res.type = FileType::Other; }
+    return res;
+}
+#else
+static FileStat StatPath(const std::string &path, bool follow_links) {
+    FileStat res;
+    std::error_code ec;
+    auto status = follow_links ? std::filesystem::status(path, ec) : std::filesystem::symlink_status(path, ec);
+    if (ec || !std::filesystem::exists(status)) { return res; }
+    if (std::filesystem::is_symlink(status)) {
+        res.type = FileType::Symlink;
+    } else if (std::filesystem::is_regular_file(status)) {
+        res.type = FileType::Regular;
+        res.size = std::filesystem::file_size(path, ec);
+    } else if (std::filesystem::is_directory(status)) {
+        res.type = FileType::Directory;
+    } else {
+        res.type = FileType::Other;
+    }
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    res.mtime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(mtime.time_since_epoch()).count();
+    return res;
+}
+#endif
+
+/**
+ * Get the type, size and modification time of a path
+ * 
+ * @param path - the path
+ * @param follow_links - stat what a symlink points at, otherwise the link
+ *                       itself, which comes back as FileType::Symlink
+ * 
+ * @return FileStat, with type None if the path could not be stat'd
+ */
+
+FileStat StatFile(const std::string& path, bool follow_links) {
+#ifdef _WIN32
+    return StatPath(path, follow_links);
+#else
+    return StatAt(AT_FDCWD, path.c_str(), follow_links);
+#endif
+}
+
+// Paths sorted so that those sharing a parent directory sit together.
+struct StatGroup {
+    std::string_view parent;
+    size_t begin;
+    size_t end;
+};
+
+static std::vector<size_t> GroupByParent(const std::vector<std::string> &paths,
+                                          std::vector<StatGroup> &groups) {
+    auto parent = [&](size_t i) {
+        std::string_view p(paths[i]);
+        size_t slash = p.find_last_of('/');
+        return slash == std::string_view::npos ? std::string_view() : p.substr(0, slash + 1);
+    };
+
+    std::vector<size_t> order(paths.size());
+    for (size_t i = 0; i < order.size(); ++i) { order[i] = i; }
+    std::stable_sort(order.begin(), order.end(),
+        [&](size_t a, size_t b) { return parent(a) < parent(b); });
+
+    for (size_t i = 0; i < order.size(); ) {
+        size_t j = i + 1;
+        std::string_view p = parent(order[i]);
+        while (j < order.size() && parent(order[j]) == p) { j++; }
+        groups.push_back({ p, i, j });
+        i = j;
+    }
+    return order;
+}
+
+// Stat one group of paths through a single directory fd.
+static void StatGroupPaths(const std::vector<std::string> &paths, const std::vector<size_t> &order,
+                           const StatGroup &group, bool follow_links, FileStats &res) {
+#ifdef _WIN32
+    for (size_t k = group.begin; k < group.end; ++k) {
+        size_t i = order[k];
+        FileStat st = StatPath(paths[i], follow_links);
+        res.types[i] = st.type;
+        res.sizes[i] = st.size;
+        res.mtimes_ns[i] = st.mtime_ns;
+    }
+#else
+    int dirfd = AT_FDCWD;
+    if (!group.parent.empty()) {
+        std::string parent(group.parent);
+#ifdef O_PATH
+        dirfd = open(parent.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+#else
+        // Without O_PATH this needs read permission on the directory, not
+        //  just search, so a failed open falls back to full paths below.
+        dirfd = open(parent.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+#endif
+    }
+    bool opened = dirfd >= 0 || dirfd == AT_FDCWD;
+
+    for (size_t k = group.begin; k < group.end; ++k) {
+        size_t i = order[k];
+        // The name is a suffix of the path, so it is already nul terminated.
+        const char *name = paths[i].c_str() + group.parent.size();
+        FileStat st;
+        if (!opened || *name == 0) {
+            st = StatAt(AT_FDCWD, paths[i].c_str(), follow_links);
+        } else {
+            st = StatAt(dirfd, name, follow_links);
+        }
+        res.types[i] = st.type;
+        res.sizes[i] = st.size;
+        res.mtimes_ns[i] = st.mtime_ns;
+    }
+
+    if (dirfd >= 0) { close(dirfd); }
+#endif
+}
+
+static FileStats MakeFileStats(size_t count) {
+    FileStats res;
+    res.types.resize(count, FileType::None);
+    res.sizes.resize(count, 0);
+    res.mtimes_ns.resize(count, 0);
+    return res;
+}
+
+/**
+ * Stat many paths at once. Paths are grouped by parent directory and each
+ * is looked up relative to an fd for that directory, which saves the kernel
+ * walking the full path every time.
+ * 
+ * @param paths - the paths
+ * @param follow_links - as for StatFile
+ * 
+ * @return FileStats in the same order as paths
+ */
+
+FileStats StatFiles(const std::vector<std::string> &paths, bool follow_links) {
+    FileStats res = MakeFileStats(paths.size());
+    std::vector<StatGroup> groups;
+    std::vector<size_t> order = GroupByParent(paths, groups);
+    for (const StatGroup &group : groups) {
+        StatGroupPaths(paths, order, group, follow_links, res);
+    }
+    return res;
+}
+
+// Wait for every future, then rethrow the first failure. The tasks write
+//  into the caller's locals, so none may still be running when it unwinds.
+static void GetAll(std::vector<std::future<void>> &futures) {
+    std::exception_ptr error;
+    for (auto &fut : futures) {
+        try {
+            fut.get();
+        } catch (...) {
+            if (!error) { error = std::current_exception(); }
+        }
+    }
+    if (error) { std::rethrow_exception(error); }
+}
+
+/**
+ * Stat many paths at once, spreading the directory groups over a pool.
+ * This waits on the pool, so don't call it from one of the pool's own
+ * tasks; with every worker waiting like that, nothing is left to run them.
+ * 
+ * @param paths - the paths
+ * @param pool - the ThreadPool to run on
+ * @param follow_links - as for StatFile
+ * 
+ * @return FileStats in the same order as paths
+ */
+
+FileStats StatFiles(const std::vector<std::string> &paths, ThreadPool &pool, bool follow_links) {
+    FileStats res = MakeFileStats(paths.size());
+    std::vector<StatGroup> groups;
+    std::vector<size_t> order = GroupByParent(paths, groups);
+
+    // A few batches per thread, cut on group boundaries, so one huge
+    //  directory does not leave the other workers idle for long.
+    size_t batches = std::max<size_t>(1, pool.size() * 4);
+    size_t per_batch = std::max<size_t>(1, (paths.size() + batches - 1) / batches);
+
+    std::vector<std::future<void>> futures;
+    try {
+        size_t g = 0;
+        while (g < groups.size()) {
+            size_t first = g;
+            size_t count = 0;
+            while (g < groups.size() && (count == 0 || count + (groups[g].end - groups[g].begin) <= per_batch)) {
+                count += groups[g].end - groups[g].begin;
+                g++;
+            }
+            size_t last = g;
+            futures.push_back(pool.execute([&, first, last]() {
+                for (size_t k = first; k < last; ++k) {
+                    StatGroupPaths(paths, order, groups[k], follow_links, res);
+                }
+            }));
+        }
+    } catch (...) {
+        for (auto &fut : futures) { fut.wait(); }
+        throw;
+    }
+
+    GetAll(futures);
+    return res;
 }
 
 /**
@@ -185,4 +468,559 @@ std::vector<std::string> ListDirs(const std::string &path, bool recurse) {
     return res;
 }
 
+#ifdef _WIN32
+namespace fs = std::experimental::filesystem;
+#else
+namespace fs = std::filesystem;
+#endif
+
+// Use the type cached from the directory read where there is one, rather
+//  than a stat per entry. The experimental filesystem has no cache.
+static inline bool IsDir(const fs::directory_entry &entry) {
+#ifdef _WIN32
+    return fs::is_directory(entry.status());
+#else
+    return entry.is_directory();
+#endif
+}
+
+static inline bool IsFile(const fs::directory_entry &entry) {
+#ifdef _WIN32
+    return fs::is_regular_file(entry.status());
+#else
+    return entry.is_regular_file();
+#endif
+}
+
+/**
+ * Walk path, adding regular files or directories to a PathList. Each
+ * directory's name is stored once and entries point back at it.
+ */
+
+static PathList WalkCompact(const std::string &path, bool recurse, bool dirs) {
+    PathList res(path);
+    if (!recurse) {
+        for (const auto & entry : fs::directory_iterator(path)) {
+            std::string name = entry.path().filename().string();
+            if (dirs && IsDir(entry)) {
+                res.add_dir(PathList::ROOT, name, true);
+            } else if (!dirs && IsFile(entry)) {
+                res.add(PathList::ROOT, name);
+            }
+        }
+        return res;
+    }
+
+    // The node for the directory currently open at each depth.
+    std::vector<uint32_t> parents{ PathList::ROOT };
+    for (auto it = fs::recursive_directory_iterator(path); it != fs::recursive_directory_iterator(); ++it) {
+        size_t depth = (size_t)it.depth();
+        uint32_t parent = parents[depth];
+        std::string name = it->path().filename().string();
+        if (IsDir(*it)) {
+            parents.resize(depth + 1);
+            parents.push_back(res.add_dir(parent, name, dirs));
+        } else if (!dirs && IsFile(*it)) {
+            res.add(parent, name);
+        }
+    }
+    res.shrink_to_fit();
+    return res;
+}
+
+/**
+ * List files inside the given path, as a compact PathList
+ * 
+ * @param path - the directory path
+ * 
+ * @return PathList of files, in the same order as ListFiles
+ */
+
+PathList ListFilesCompact(const std::string &path, bool recurse) {
+    return WalkCompact(path, recurse, false);
+}
+
+/**
+ * List directories inside the given path, as a compact PathList
+ * 
+ * @param path - the directory path
+ * 
+ * @return PathList of directories, in the same order as ListDirs
+ */
+
+PathList ListDirsCompact(const std::string &path, bool recurse) {
+    return WalkCompact(path, recurse, true);
+}
+
+// Low level helpers for the writers below, so the classes stay free of
+//  platform ifdefs.
+
+static std::string ErrorString(const std::string &what, const std::string &path) {
+    return what + " " + path + ": " + std::strerror(errno);
+}
+
+static std::string ParentDir(const std::string &path) {
+    size_t slash = path.find_last_of("\\/");
+    if (slash == std::string::npos) { return "."; }
+    if (slash == 0) { return "/"; }
+    return path.substr(0, slash);
+}
+
+// A hidden name next to path that no other writer will pick.
+static std::string TempNameFor(const std::string &path) {
+    static std::atomic<uint64_t> counter{ 0 };
+    size_t slash = path.find_last_of("\\/");
+    std::string dir = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+#ifdef _WIN32
+    int pid = _getpid();
+#else
+    int pid = (int)getpid();
+#endif
+    return dir + "." + name + "." + std::to_string(pid) + "." + std::to_string(counter++) + ".tmp";
+}
+
+static int OpenForWrite(const std::string &path, bool exclusive) {
+#ifdef _WIN32
+    return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_BINARY | (exclusive ? _O_EXCL : _O_TRUNC),
+                 _S_IREAD | _S_IWRITE);
+#else
+    return ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (exclusive ? O_EXCL : O_TRUNC), 0666);
+#endif
+}
+
+// Create a fresh temp file for path, filling in temp with its name. If path
+//  already exists the temp file takes its mode, so renaming it over does not
+//  lose (say) the executable bit.
+static int OpenTempFor(const std::string &path, std::string &temp) {
+    int fd = -1;
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        temp = TempNameFor(path);
+        fd = OpenForWrite(temp, true);
+        if (fd >= 0 || errno != EEXIST) { break; }
+    }
+#ifndef _WIN32
+    struct stat st;
+    if (fd >= 0 && stat(path.c_str(), &st) == 0 && fchmod(fd, st.st_mode & 07777) != 0) {
+        int error = errno;
+        ::close(fd);
+        unlink(temp.c_str());
+        errno = error;
+        return -1;
+    }
+#endif
+    return fd;
+}
+
+static bool WriteAll(int fd, const char *data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        int n = _write(fd, data, (unsigned int)std::min<size_t>(size, 1u << 30));
+#else
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0 && errno == EINTR) { continue; }
+#endif
+        if (n <= 0) { return false; }
+        data += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+static bool SyncData(int fd) {
+#if defined(_WIN32)
+    return _commit(fd) == 0;
+#elif defined(__APPLE__)
+    return fsync(fd) == 0;
+#else
+    return fdatasync(fd) == 0;
+#endif
+}
+
+// Make renames in dir durable.
+static void SyncDir(const std::string &dir) {
+#ifndef _WIN32
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        fsync(fd);
+        ::close(fd);
+    }
+#else
+    (void)dir;
+#endif
+}
+
+static int CloseFd(int fd) {
+#ifdef _WIN32
+    return _close(fd);
+#else
+    return ::close(fd);
+#endif
+}
+
+static bool RemoveFile(const std::string &path) {
+#ifdef _WIN32
+    return _unlink(path.c_str()) == 0;
+#else
+    return unlink(path.c_str()) == 0;
+#endif
+}
+
+static bool RenameOver(const std::string &from, const std::string &to) {
+#ifdef _WIN32
+    std::error_code ec;
+    std::experimental::filesystem::rename(from, to, ec);
+    return !ec;
+#else
+    return ::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+static char *AllocAligned(size_t size) {
+#ifdef _WIN32
+    char *p = static_cast<char *>(_aligned_malloc(size, 4096));
+#else
+    char *p = static_cast<char *>(std::aligned_alloc(4096, size));
+#endif
+    if (p == nullptr) { throw std::bad_alloc(); }
+    return p;
+}
+
+static void FreeAligned(char *p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+FileWriter::FileWriter(const std::string &filename, const WriteOptions &options) {
+    open(filename, options);
+}
+
+FileWriter::~FileWriter() {
+    if (is_open()) {
+        if (_options.atomic) {
+            abandon();
+        } else {
+            try { close(); } catch (...) {}
+        }
+    }
+    if (_buffer) { FreeAligned(_buffer); }
+}
+
+/**
+ * Open a file for writing, truncating it unless the write is atomic
+ * 
+ * @param filename - the file path
+ * @param options - how to write
+ */
+
+void FileWriter::open(const std::string &filename, const WriteOptions &options) {
+    if (is_open()) { close(); }
+
+    _filename = filename;
+    _options = options;
+    _written = 0;
+    _used = 0;
+    _direct = false;
+
+    if (_options.atomic) {
+        _fd = OpenTempFor(filename, _temp);
+    } else {
+        _temp.clear();
+        _fd = OpenForWrite(filename, false);
+    }
+    if (_fd < 0) {
+        throw std::runtime_error(ErrorString("failed to open", _options.atomic ? _temp : filename));
+    }
+
+    size_t capacity = std::max<size_t>(4096, (_options.buffer_size + 4095) & ~(size_t)4095);
+    if (capacity != _capacity && _buffer) {
+        FreeAligned(_buffer);
+        _buffer = nullptr;
+    }
+    _capacity = capacity;
+
+#ifdef O_DIRECT
+    // Filesystems without O_DIRECT (tmpfs) refuse it; carry on buffered.
+    if (_options.direct) {
+        int flags = fcntl(_fd, F_GETFL);
+        _direct = flags >= 0 && fcntl(_fd, F_SETFL, flags | O_DIRECT) == 0;
+    }
+#endif
+#if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+    // Best effort; one extent up front makes later writes cheaper. The size
+    //  is left alone, so a writer that dies early leaves no zero padding.
+    if (_options.preallocate > 0) {
+        fallocate(_fd, FALLOC_FL_KEEP_SIZE, 0, (off_t)_options.preallocate);
+    }
+#endif
+}
+
+void FileWriter::_fail(const std::string &what) {
+    std::string message = ErrorString(what, _filename);
+    abandon();
+    throw std::runtime_error(message);
+}
+
+void FileWriter::_write_out(const char *data, size_t size) {
+    if (!WriteAll(_fd, data, size)) { _fail("failed to write"); }
+    _written += size;
+}
+
+/**
+ * Append bytes to the file
+ * 
+ * @param data - the bytes
+ * @param size - how many
+ */
+
+void FileWriter::write(const void *data, size_t size) {
+    if (!is_open()) { throw std::runtime_error("FileWriter is not open"); }
+    const char *p = static_cast<const char *>(data);
+
+    while (size > 0) {
+        // Big writes go straight from the caller's memory when they can.
+        //  O_DIRECT needs our aligned buffer so always copies.
+        if (_used == 0 && !_direct && size >= _capacity) {
+            _write_out(p, size);
+            return;
+        }
+        if (_buffer == nullptr) { _buffer = AllocAligned(_capacity); }
+
+        size_t n = std::min(size, _capacity - _used);
+        std::memcpy(_buffer + _used, p, n);
+        _used += n;
+        p += n;
+        size -= n;
+
+        if (_used == _capacity) {
+            _write_out(_buffer, _used);
+            _used = 0;
+        }
+    }
+}
+
+/**
+ * Hand buffered data to the kernel. With O_DIRECT a partial last block is
+ * kept back, as direct writes must be whole blocks.
+ */
+
+void FileWriter::flush() {
+    if (!is_open() || _used == 0) { return; }
+    size_t n = _direct ? (_used & ~(size_t)4095) : _used;
+    if (n > 0) {
+        _write_out(_buffer, n);
+        std::memmove(_buffer, _buffer + n, _used - n);
+        _used -= n;
+    }
+}
+
+/**
+ * Write everything out and close. For atomic writers this syncs the data
+ * and renames the temp file over the target. Throws on failure, in which
+ * case an atomic target is left untouched.
+ */
+
+void FileWriter::close() {
+    if (!is_open()) { return; }
+    flush();
+
+#ifdef O_DIRECT
+    // Only a partial O_DIRECT block can be left; write it the normal way.
+    if (_used > 0) {
+        int flags = fcntl(_fd, F_GETFL);
+        fcntl(_fd, F_SETFL, flags & ~O_DIRECT);
+        _direct = false;
+        _write_out(_buffer, _used);
+        _used = 0;
+    }
+#endif
+
+#ifndef _WIN32
+    // Give back any reserved space past what we wrote. The size is already
+    //  right, but blocks kept past the end stay allocated until a truncate.
+    if (_options.preallocate > 0 && ftruncate(_fd, (off_t)_written) != 0) {
+        _fail("failed to truncate");
+    }
+#endif
+
+    if ((_options.sync || _options.atomic) && !SyncData(_fd)) { _fail("failed to sync"); }
+
+    int fd = _fd;
+    _fd = -1;
+    if (CloseFd(fd) != 0) {
+        std::string message = ErrorString("failed to close", _filename);
+        if (!_temp.empty()) { RemoveFile(_temp); }
+        throw std::runtime_error(message);
+    }
+
+    if (!_temp.empty()) {
+        if (!RenameOver(_temp, _filename)) {
+            std::string message = ErrorString("failed to rename over", _filename);
+            RemoveFile(_temp);
+            _temp.clear();
+            throw std::runtime_error(message);
+        }
+        _temp.clear();
+        if (_options.sync) { SyncDir(ParentDir(_filename)); }
+    }
+}
+
+/**
+ * Close without publishing. An atomic writer's temp file is removed and the
+ * target is left as it was.
+ */
+
+void FileWriter::abandon() {
+    if (_fd >= 0) {
+        CloseFd(_fd);
+        _fd = -1;
+    }
+    if (!_temp.empty()) {
+        RemoveFile(_temp);
+        _temp.clear();
+    }
+    _used = 0;
+}
+
+/**
+ * Write a whole file in one go
+ * 
+ * @param filename - the file path
+ * @param data - the bytes
+ * @param size - how many
+ * @param options - how to write
+ */
+
+static const size_t WRITE_PREALLOCATE_MIN = 16 << 20;
+
+void WriteFile(const std::string& filename, const void *data, size_t size, const WriteOptions &options) {
+    WriteOptions opts = options;
+    // Everything arrives at once, so a big buffer only helps O_DIRECT.
+    if (!opts.direct) { opts.buffer_size = 4096; }
+    // Small files go out in one write anyway; the extra syscall isn't worth it.
+    if (opts.preallocate == 0 && size >= WRITE_PREALLOCATE_MIN) { opts.preallocate = size; }
+    FileWriter writer(filename, opts);
+    writer.write(data, size);
+    writer.close();
+}
+
+void WriteFile(const std::string& filename, std::string_view data, const WriteOptions &options) {
+    WriteFile(filename, data.data(), data.size(), options);
+}
+
+void WriteFile(const std::string& filename, const std::vector<char> &data, const WriteOptions &options) {
+    WriteFile(filename, data.data(), data.size(), options);
+}
+
+void WriteBatch::add(const std::string &filename, std::string data) {
+    _files.push_back({ filename, std::move(data) });
+}
+
+void WriteBatch::add(const std::string &filename, const std::vector<char> &data) {
+    _files.push_back({ filename, std::string(data.begin(), data.end()) });
+}
+
+// Write, sync and rename files [begin, end) in windows, so we never hold
+//  too many descriptors open at once.
+void WriteBatch::_commit_range(size_t begin, size_t end) {
+    const size_t window = 128;
+    for (size_t first = begin; first < end; first += window) {
+        size_t last = std::min(end, first + window);
+        std::vector<int> fds;
+        std::vector<std::string> temps;
+        size_t renamed = 0;
+
+        try {
+            for (size_t i = first; i < last; ++i) {
+                std::string temp;
+                int fd = OpenTempFor(_files[i].filename, temp);
+                if (fd < 0) { throw std::runtime_error(ErrorString("failed to open", temp)); }
+                fds.push_back(fd);
+                temps.push_back(temp);
+                if (!WriteAll(fd, _files[i].data.data(), _files[i].data.size())) {
+                    throw std::runtime_error(ErrorString("failed to write", temp));
+                }
+#ifdef SYNC_FILE_RANGE_WRITE
+                // Start writeback now; the fdatasync below then mostly just waits.
+                if (_durable) { sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WRITE); }
+#endif
+            }
+
+            for (size_t k = 0; k < fds.size(); ++k) {
+                if (_durable && !SyncData(fds[k])) {
+                    throw std::runtime_error(ErrorString("failed to sync", temps[k]));
+                }
+                int fd = fds[k];
+                fds[k] = -1;
+                if (CloseFd(fd) != 0) {
+                    throw std::runtime_error(ErrorString("failed to close", temps[k]));
+                }
+            }
+
+            for (; renamed < temps.size(); ++renamed) {
+                if (!RenameOver(temps[renamed], _files[first + renamed].filename)) {
+                    throw std::runtime_error(ErrorString("failed to rename over", _files[first + renamed].filename));
+                }
+            }
+        } catch (...) {
+            for (int fd : fds) {
+                if (fd >= 0) { CloseFd(fd); }
+            }
+            for (size_t k = renamed; k < temps.size(); ++k) { RemoveFile(temps[k]); }
+            throw;
+        }
+    }
+}
+
+void WriteBatch::_sync_dirs() {
+    if (!_durable) { return; }
+    std::set<std::string> dirs;
+    for (const Pending &file : _files) { dirs.insert(ParentDir(file.filename)); }
+    for (const std::string &dir : dirs) { SyncDir(dir); }
+}
+
+/**
+ * Write every file in the batch. Each one is replaced atomically; when the
+ * batch is durable the data and the directories are synced before this
+ * returns. On failure the batch is kept, and files already renamed stay.
+ */
+
+void WriteBatch::commit() {
+    _commit_range(0, _files.size());
+    _sync_dirs();
+    _files.clear();
+}
+
+/**
+ * Write every file in the batch, spreading the writes over a pool
+ * 
+ * @param pool - the ThreadPool to run on
+ */
+
+void WriteBatch::commit(ThreadPool &pool) {
+    size_t tasks = std::max<size_t>(1, pool.size() * 2);
+    size_t per_task = std::max<size_t>(1, (_files.size() + tasks - 1) / tasks);
+
+    std::vector<std::future<void>> futures;
+    for (size_t begin = 0; begin < _files.size(); begin += per_task) {
+        size_t end = std::min(_files.size(), begin + per_task);
+        futures.push_back(pool.execute([this, begin, end]() { _commit_range(begin, end); }));
+    }
+
+    std::exception_ptr error;
+    for (auto &fut : futures) {
+        try {
+            fut.get();
+        } catch (...) {
+            if (!error) { error = std::current_exception(); }
+        }
+    }
+    _sync_dirs();
+    if (error) { std::rethrow_exception(error); }
+    _files.clear();
+}
+
 }
\ No newline at end of file
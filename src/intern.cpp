@@ -0,0 +1,168 @@
+/**
+ *  (     (                           
+ *  )\ )  )\ )   (     (              
+ * (()/( (()/( ( )\    )\   (    (    
+ *  /(_)) /(_)))((_) (((_)  )\   )\   
+ * (_))  (_)) ((_)_  )\___ ((_) ((_)  
+ * | |   |_ _| | _ )((/ __|| __|| __| 
+ * | |__  | |  | _ \ | (__ | _| | _|  
+ * |____||___| |___/  \___||___||___| 
+ *                                             
+ * @file intern.cpp
+ * @author Benjamin Blundell - me@benjamin.computer
+ * @date 18/10/2026
+ * @brief A thread safe string interner / symbol table.
+ *
+ */
+
+#include "intern.hpp"
+
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+namespace libcee {
+
+StringInterner::StringInterner(size_t shard_count) {
+    while ((size_t(1) << _shard_bits) < shard_count && _shard_bits < 6) { _shard_bits++; }
+    for (size_t i = 0; i < (size_t(1) << _shard_bits); ++i) {
+        _shards.push_back(std::make_unique<Shard>());
+    }
+}
+
+// Pick the shard from the top bits of the hash; the tables use the low
+//  bits, so the two choices don't correlate.
+size_t StringInterner::_shard_of(std::string_view str) const {
+    size_t hash = std::hash<std::string_view>()(str);
+    if (_shard_bits == 0) { return 0; }
+    uint64_t mixed = (uint64_t)hash * 0x9E3779B97F4A7C15ull;
+    return (size_t)(mixed >> (64 - _shard_bits));
+}
+
+InternId StringInterner::_insert(Shard &shard, size_t shard_index, std::string_view str,
+                                 std::string_view *stored) {
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+
+    // Someone may have beaten us to it between the two locks.
+    auto found = shard.table.find(str);
+    if (found != shard.table.end()) {
+        if (stored) { *stored = shard.strings[found->second >> _shard_bits]; }
+        return found->second;
+    }
+
+    if ((shard.strings.size() + 1) >> (32 - _shard_bits) != 0) {
+        throw std::length_error("StringInterner is full");
+    }
+
+    char *data = static_cast<char *>(shard.arena.allocate(str.size() + 1, 1));
+    std::memcpy(data, str.data(), str.size());
+    data[str.size()] = 0;
+    std::string_view copy(data, str.size());
+
+    InternId id = (InternId)((shard.strings.size() << _shard_bits) | shard_index);
+    shard.strings.push_back(copy);
+    shard.table.emplace(copy, id);
+
+    if (stored) { *stored = copy; }
+    return id;
+}
+
+/**
+ * Intern a string
+ *
+ * @param str - the string
+ *
+ * @return the id for str, the same for every equal string
+ */
+
+InternId StringInterner::intern(std::string_view str) {
+    size_t index = _shard_of(str);
+    Shard &shard = *_shards[index];
+    {
+        // Most calls find an existing string, so try under the shared lock first.
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto found = shard.table.find(str);
+        if (found != shard.table.end()) { return found->second; }
+    }
+    return _insert(shard, index, str, nullptr);
+}
+
+/**
+ * Intern a string and return the interned copy
+ *
+ * @param str - the string
+ *
+ * @return a view that stays valid for the life of the interner
+ */
+
+std::string_view StringInterner::intern_view(std::string_view str) {
+    size_t index = _shard_of(str);
+    Shard &shard = *_shards[index];
+    {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto found = shard.table.find(str);
+        if (found != shard.table.end()) { return found->first; }
+    }
+    std::string_view stored;
+    _insert(shard, index, str, &stored);
+    return stored;
+}
+
+/**
+ * Look up a string without adding it
+ *
+ * @param str - the string
+ *
+ * @return the id, or nothing if str has not been interned
+ */
+
+std::optional<InternId> StringInterner::find(std::string_view str) const {
+    const Shard &shard = *_shards[_shard_of(str)];
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto found = shard.table.find(str);
+    if (found == shard.table.end()) { return std::nullopt; }
+    return found->second;
+}
+
+std::string_view StringInterner::view(InternId id) const {
+    const Shard &shard = *_shards[id & ((1u << _shard_bits) - 1)];
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    size_t local = id >> _shard_bits;
+    if (local >= shard.strings.size()) {
+        throw std::out_of_range("InternId not from this StringInterner");
+    }
+    return shard.strings[local];
+}
+
+size_t StringInterner::size() const {
+    size_t count = 0;
+    for (auto &shard : _shards) {
+        std::shared_lock<std::shared_mutex> lock(shard->mutex);
+        count += shard->strings.size();
+    }
+    return count;
+}
+
+/**
+ * Report how much memory the interner is holding on to
+ *
+ * @return MemoryUsage, the table part is an estimate of node and bucket sizes
+ */
+
+StringInterner::MemoryUsage StringInterner::memory_usage() const {
+    MemoryUsage usage;
+    // An unordered_map node is roughly a next pointer, the value and the cached hash.
+    const size_t node_bytes = sizeof(void *) + sizeof(std::pair<const std::string_view, InternId>) + sizeof(size_t);
+    for (auto &shard : _shards) {
+        std::shared_lock<std::shared_mutex> lock(shard->mutex);
+        usage.string_bytes += shard->arena.bytes_used();
+        usage.arena_bytes += shard->arena.bytes_reserved();
+        usage.table_bytes += shard->table.bucket_count() * sizeof(void *);
+        usage.table_bytes += shard->table.size() * node_bytes;
+        usage.table_bytes += shard->strings.capacity() * sizeof(std::string_view);
+    }
+    usage.table_bytes += sizeof(*this) + _shards.size() * sizeof(Shard);
+    return usage;
+}
+
+}
@@ -0,0 +1,140 @@
+/**
+ *  (     (                           
+ *  )\ )  )\ )   (     (              
+ * (()/( (()/( ( )\    )\   (    (    
+ *  /(_)) /(_)))((_) (((_)  )\   )\   
+ * (_))  (_)) ((_)_  )\___ ((_) ((_)  
+ * | |   |_ _| | _ )((/ __|| __|| __| 
+ * | |__  | |  | _ \ | (__ | _| | _|  
+ * |____||___| |___/  \___||___||___| 
+ *                                             
+ * @file pathlist.cpp
+ * @author Benjamin Blundell - me@benjamin.computer
+ * @date 18/10/2026
+ * @brief A compact list of paths that share directory prefixes.
+ *
+ */
+
+#include "pathlist.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace libcee {
+
+PathList::PathList(std::string_view root) {
+    // The root has no parent; it points at itself and _build stops there.
+    _dirs.push_back(_store(ROOT, root));
+}
+
+PathList::Node PathList::_store(uint32_t parent, std::string_view name) {
+    if (_names.size() + name.size() > UINT32_MAX) {
+        throw std::length_error("PathList names are over 4GB");
+    }
+    Node node{ parent, (uint32_t)_names.size(), (uint32_t)name.size() };
+    _names.insert(_names.end(), name.begin(), name.end());
+    return node;
+}
+
+uint32_t PathList::add_dir(uint32_t parent, std::string_view name, bool listed) {
+    if (_dirs.size() >= UINT32_MAX) {
+        throw std::length_error("PathList has too many directories");
+    }
+    Node node = _store(parent, name);
+    _dirs.push_back(node);
+    // A listed directory shares its name with the directory node.
+    if (listed) { _entries.push_back(node); }
+    return (uint32_t)(_dirs.size() - 1);
+}
+
+void PathList::add(uint32_t parent, std::string_view name) {
+    _entries.push_back(_store(parent, name));
+}
+
+// Join node's ancestors from the root down, the same way std::filesystem
+//  does: a separator is only added if the parent doesn't end in one. The
+//  first pass finds the length, the second fills the string from the back.
+static inline bool NeedsSeparator(std::string_view part) {
+    return !part.empty() && part.back() != '/' && part.back() != '\\';
+}
+
+void PathList::_build(const Node &node, std::string &out) const {
+    size_t length = node.length;
+    uint32_t dir = node.parent;
+    while (true) {
+        std::string_view part = _name_of(_dirs[dir]);
+        length += part.size() + (NeedsSeparator(part) ? 1 : 0);
+        if (dir == ROOT) { break; }
+        dir = _dirs[dir].parent;
+    }
+
+    out.resize(length);
+    size_t pos = length - node.length;
+    std::copy(_names.data() + node.offset, _names.data() + node.offset + node.length, &out[pos]);
+    dir = node.parent;
+    while (true) {
+        std::string_view part = _name_of(_dirs[dir]);
+        if (NeedsSeparator(part)) { out[--pos] = '/'; }
+        pos -= part.size();
+        std::copy(part.begin(), part.end(), &out[pos]);
+        if (dir == ROOT) { break; }
+        dir = _dirs[dir].parent;
+    }
+}
+
+/**
+ * The full path of an entry
+ *
+ * @param i - the entry index
+ *
+ * @return the path
+ */
+
+std::string PathList::path(size_t i) const {
+    std::string out;
+    _build(_entries[i], out);
+    return out;
+}
+
+/**
+ * The full path of an entry, written into out so its buffer can be reused
+ *
+ * @param i - the entry index
+ * @param out - the string to write to
+ */
+
+void PathList::path(size_t i, std::string &out) const {
+    _build(_entries[i], out);
+}
+
+std::string PathList::dir_path(uint32_t node) const {
+    std::string out;
+    if (node == ROOT) {
+        std::string_view root = _name_of(_dirs[ROOT]);
+        return std::string(root.data(), root.size());
+    }
+    _build(_dirs[node], out);
+    return out;
+}
+
+std::vector<std::string> PathList::to_vector() const {
+    std::vector<std::string> res;
+    res.reserve(_entries.size());
+    for (size_t i = 0; i < _entries.size(); ++i) {
+        res.push_back(path(i));
+    }
+    return res;
+}
+
+size_t PathList::memory_usage() const {
+    return sizeof(*this) + _names.capacity() +
+        (_dirs.capacity() + _entries.capacity()) * sizeof(Node);
+}
+
+void PathList::shrink_to_fit() {
+    _names.shrink_to_fit();
+    _dirs.shrink_to_fit();
+    _entries.shrink_to_fit();
+}
+
+}
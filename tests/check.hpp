@@ -0,0 +1,43 @@
+#ifndef __libcee_TESTS_CHECK_H__
+#define __libcee_TESTS_CHECK_H__
+
+/**
+ * @file check.hpp
+ * @brief Just enough of a test harness for the libcee tests. Unlike assert
+ * these still run in release builds, and a failure doesn't stop the rest.
+ */
+
+#include <cstdio>
+
+namespace libcee {
+
+inline int &CheckFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+}
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+        libcee::CheckFailures()++; \
+    } \
+} while (0)
+
+#define CHECK_THROWS(expr, type) do { \
+    bool _threw = false; \
+    try { (void)(expr); } catch (const type &) { _threw = true; } \
+    if (!_threw) { \
+        std::fprintf(stderr, "%s:%d: CHECK_THROWS failed: %s\n", __FILE__, __LINE__, #expr); \
+        libcee::CheckFailures()++; \
+    } \
+} while (0)
+
+#define RUN(test) do { \
+    int _before = libcee::CheckFailures(); \
+    test(); \
+    std::printf("%-32s %s\n", #test, libcee::CheckFailures() == _before ? "ok" : "FAILED"); \
+} while (0)
+
+#endif
@@ -0,0 +1,118 @@
+/**
+ *  (     (
+ *  )\ )  )\ )   (     (
+ * (()/( (()/( ( )\    )\   (    (
+ *  /(_)) /(_)))((_) (((_)  )\   )\
+ * (_))  (_)) ((_)_  )\___ ((_) ((_)
+ * | |   |_ _| | _ )((/ __|| __|| __|
+ * | |__  | |  | _ \ | (__ | _| | _|
+ * |____||___| |___/  \___||___||___|
+ *
+ * @file concurrentmap_test.cpp
+ * @author Benjamin Blundell - me@benjamin.computer
+ * @date 18/10/2026
+ * @brief Tests for FlatMap, ConcurrentHashMap and its combiners.
+ *
+ */
+
+#include "concurrentmap.hpp"
+#include "threadpool.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+
+using namespace libcee;
+
+static void TestFlatMap() {
+    FlatMap<uint64_t, uint64_t> map;
+    for (uint64_t i = 0; i < 10000; ++i) { map.upsert(i % 1000, 1); }
+    CHECK(map.size() == 1000);
+    CHECK(map.find(7) != nullptr && *map.find(7) == 10);
+    CHECK(map.find(1000) == nullptr);
+    map[1000] = 3;
+    CHECK(*map.find(1000) == 3);
+}
+
+static void TestUpsert() {
+    ConcurrentHashMap<std::string, uint64_t> counts(16);
+    ThreadPool pool(4);
+    std::vector<std::future<void>> futures;
+    for (int t = 0; t < 8; ++t) {
+        futures.push_back(pool.execute([&]() {
+            for (int i = 0; i < 1000; ++i) { counts.upsert(std::to_string(i % 100), 1); }
+        }));
+    }
+    for (auto &fut : futures) { fut.get(); }
+    CHECK(counts.size() == 100);
+    CHECK(counts.find("42") == 80u);
+    CHECK(!counts.find("100"));
+}
+
+static void TestCombiners() {
+    ConcurrentHashMap<uint64_t, uint64_t> counts(8);
+    ThreadPool pool(3);
+    std::vector<ConcurrentHashMap<uint64_t, uint64_t>::Combiner> parts;
+    for (size_t i = 0; i < pool.max_size(); ++i) { parts.push_back(counts.make_combiner()); }
+
+    std::vector<std::future<void>> futures;
+    for (int t = 0; t < 30; ++t) {
+        futures.push_back(pool.execute([&]() {
+            auto &part = parts[ThreadPool::current_worker()->index];
+            for (uint64_t i = 0; i < 500; ++i) { part.upsert(i, 1); }
+        }));
+    }
+    for (auto &fut : futures) { fut.get(); }
+    counts.merge(parts, pool);
+    CHECK(counts.size() == 500);
+    CHECK(counts.find(499) == 30u);
+    for (const auto &part : parts) { CHECK(part.size() == 0); }
+
+    // Combiners must come from this map.
+    ConcurrentHashMap<uint64_t, uint64_t> other(32);
+    auto stranger = other.make_combiner();
+    CHECK_THROWS(counts.merge(stranger), std::invalid_argument);
+}
+
+// A throwing merge reaches the caller only once every shard task is done
+//  with the combiners.
+static void TestMergeThrows() {
+    ConcurrentHashMap<uint64_t, uint64_t> counts(16);
+    ThreadPool pool(4);
+    for (uint64_t i = 0; i < 1000; ++i) { counts.upsert(i, 1); }
+
+    std::vector<ConcurrentHashMap<uint64_t, uint64_t>::Combiner> parts;
+    for (int p = 0; p < 4; ++p) {
+        parts.push_back(counts.make_combiner());
+        for (uint64_t i = 0; i < 1000; ++i) { parts.back().upsert(i, 1); }
+    }
+
+    std::atomic<int> running{ 0 };
+    bool overlapped = false;
+    auto merge = [&](uint64_t &existing, const uint64_t &incoming) {
+        running++;
+        existing += incoming;
+        running--;
+        if (existing == 3) { throw std::runtime_error("merge"); }
+    };
+    try {
+        counts.merge(parts, pool, merge);
+    } catch (const std::runtime_error &) {
+        overlapped = running != 0;
+    }
+    CHECK(!overlapped);
+    CHECK(running == 0);
+}
+
+int main() {
+    RUN(TestFlatMap);
+    RUN(TestUpsert);
+    RUN(TestCombiners);
+    RUN(TestMergeThrows);
+    return CheckFailures() == 0 ? 0 : 1;
+}
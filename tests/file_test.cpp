@@ -0,0 +1,208 @@
+/**
+ *  (     (
+ *  )\ )  )\ )   (     (
+ * (()/( (()/( ( )\    )\   (    (
+ *  /(_)) /(_)))((_) (((_)  )\   )\
+ * (_))  (_)) ((_)_  )\___ ((_) ((_)
+ * | |   |_ _| | _ )((/ __|| __|| __|
+ * | |__  | |  | _ \ | (__ | _| | _|
+ * |____||___| |___/  \___||___||___|
+ *
+ * @file file_test.cpp
+ * @author Benjamin Blundell - me@benjamin.computer
+ * @date 18/10/2026
+ * @brief Tests for FileWriter, WriteFile, WriteBatch and StatFiles.
+ *
+ */
+
+#include "file.hpp"
+#include "string.hpp"
+#include "threadpool.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "check.hpp"
+
+using namespace libcee;
+
+#ifndef _WIN32
+
+static std::string _dir;
+
+static std::string Path(const std::string &name) { return _dir + "/" + name; }
+
+static std::string Contents(const std::string &path) {
+    std::vector<char> data = ReadFile(path);
+    return std::string(data.begin(), data.end());
+}
+
+static struct stat Stat(const std::string &path) {
+    struct stat st {};
+    stat(path.c_str(), &st);
+    return st;
+}
+
+// Anything left in the directory that isn't one of our targets.
+static size_t TempFiles() {
+    size_t count = 0;
+    for (const std::string &file : ListFiles(_dir)) {
+        if (FilenameFromPath(file).rfind(".", 0) == 0) { count++; }
+    }
+    return count;
+}
+
+static void TestWriteFile() {
+    WriteFile(Path("plain"), std::string_view("hello"));
+    CHECK(Contents(Path("plain")) == "hello");
+
+    WriteOptions atomic;
+    atomic.atomic = true;
+    std::vector<char> data{ 'a', 'b', 'c' };
+    WriteFile(Path("plain"), data, atomic);
+    CHECK(Contents(Path("plain")) == "abc");
+
+    std::string big(3 << 20, 'x');
+    big[12345] = 'y';
+    WriteFile(Path("big"), big);
+    CHECK(Contents(Path("big")) == big);
+    CHECK(TempFiles() == 0);
+}
+
+static void TestAtomicReplace() {
+    WriteFile(Path("target"), std::string_view("old"));
+    WriteOptions atomic;
+    atomic.atomic = true;
+
+    {
+        FileWriter writer(Path("target"), atomic);
+        writer.write("new data");
+        writer.flush();
+        // Nothing shows until close.
+        CHECK(Contents(Path("target")) == "old");
+        writer.close();
+    }
+    CHECK(Contents(Path("target")) == "new data");
+
+    {
+        FileWriter writer(Path("target"), atomic);
+        writer.write("thrown away");
+        writer.abandon();
+    }
+    CHECK(Contents(Path("target")) == "new data");
+
+    {
+        // Destroyed without close() counts as abandoned.
+        FileWriter writer(Path("target"), atomic);
+        writer.write("also thrown away");
+    }
+    CHECK(Contents(Path("target")) == "new data");
+    CHECK(TempFiles() == 0);
+
+    // The replacement keeps the target's mode.
+    chmod(Path("target").c_str(), 0751);
+    WriteFile(Path("target"), std::string_view("#!/bin/sh\n"), atomic);
+    CHECK((Stat(Path("target")).st_mode & 07777) == 0751);
+}
+
+static void TestPreallocate() {
+    // Reserved space past what was written is given back on close.
+    WriteOptions options;
+    options.preallocate = 64 << 20;
+    {
+        FileWriter writer(Path("small"), options);
+        writer.write("abc");
+        writer.flush();
+        CHECK(Stat(Path("small")).st_size == 3);
+        writer.close();
+    }
+    struct stat st = Stat(Path("small"));
+    CHECK(st.st_size == 3);
+    CHECK((uint64_t)st.st_blocks * 512 < (1 << 20));
+
+    // The same through an atomic, O_DIRECT writer with a partial last block.
+    options.preallocate = 1 << 20;
+    options.atomic = true;
+    options.direct = true;
+    std::string data(1000004, 'd');
+    {
+        FileWriter writer(Path("direct"), options);
+        writer.write(data);
+        writer.close();
+    }
+    st = Stat(Path("direct"));
+    CHECK(st.st_size == (off_t)data.size());
+    CHECK((uint64_t)st.st_blocks * 512 < data.size() + 64 * 1024);
+    CHECK(Contents(Path("direct")) == data);
+}
+
+static void TestWriteBatch() {
+    ThreadPool pool(3);
+    for (int durable = 0; durable < 2; ++durable) {
+        WriteBatch batch(durable != 0);
+        for (int i = 0; i < 300; ++i) {
+            batch.add(Path("batch" + std::to_string(i)), std::to_string(i * durable));
+        }
+        if (durable) { batch.commit(pool); } else { batch.commit(); }
+        CHECK(batch.size() == 0);
+        for (int i = 0; i < 300; i += 37) {
+            CHECK(Contents(Path("batch" + std::to_string(i))) == std::to_string(i * durable));
+        }
+    }
+    CHECK(TempFiles() == 0);
+
+    // A failed batch is kept, and leaves no temp files behind.
+    WriteBatch batch;
+    batch.add(Path("missing/dir/file"), std::string("x"));
+    CHECK_THROWS(batch.commit(), std::runtime_error);
+    CHECK(batch.size() == 1);
+    CHECK(TempFiles() == 0);
+}
+
+static void TestStatFiles() {
+    WriteFile(Path("stat"), std::string_view("12345"));
+    symlink("stat", Path("link").c_str());
+    std::vector<std::string> paths{ Path("stat"), Path("link"), Path("none"), _dir };
+
+    ThreadPool pool(2);
+    FileStats followed = StatFiles(paths, pool);
+    CHECK(followed.types[0] == FileType::Regular && followed.sizes[0] == 5);
+    CHECK(followed.types[1] == FileType::Regular);
+    CHECK(!followed.exists(2));
+    CHECK(followed.types[3] == FileType::Directory);
+
+    FileStats links = StatFiles(paths, false);
+    CHECK(links.types[1] == FileType::Symlink);
+    CHECK(StatFile(Path("link"), false).type == FileType::Symlink);
+    CHECK(StatFile(Path("stat")).mtime_ns == followed.mtimes_ns[0]);
+}
+
+int main() {
+    char dir[] = "/tmp/libcee_file_test.XXXXXX";
+    if (mkdtemp(dir) == nullptr) { return 1; }
+    _dir = dir;
+
+    RUN(TestWriteFile);
+    RUN(TestAtomicReplace);
+    RUN(TestPreallocate);
+    RUN(TestWriteBatch);
+    RUN(TestStatFiles);
+
+    std::string cleanup = "rm -rf '" + _dir + "'";
+    if (std::system(cleanup.c_str()) != 0) { return 1; }
+    return CheckFailures() == 0 ? 0 : 1;
+}
+
+#else
+
+int main() { return 0; }
+
+#endif
@@ -0,0 +1,177 @@
+/**
+ *  (     (
+ *  )\ )  )\ )   (     (
+ * (()/( (()/( ( )\    )\   (    (
+ *  /(_)) /(_)))((_) (((_)  )\   )\
+ * (_))  (_)) ((_)_  )\___ ((_) ((_)
+ * | |   |_ _| | _ )((/ __|| __|| __|
+ * | |__  | |  | _ \ | (__ | _| | _|
+ * |____||___| |___/  \___||___||___|
+ *
+ * @file threadpool_test.cpp
+ * @author Benjamin Blundell - me@benjamin.computer
+ * @date 18/10/2026
+ * @brief Tests for ThreadPool, mostly elastic growth and retirement.
+ *
+ */
+
+#include "threadpool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "check.hpp"
+
+using namespace libcee;
+using namespace std::chrono_literals;
+using Clock = std::chrono::steady_clock;
+
+static void TestResults() {
+    ThreadPool pool(3);
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 100; ++i) {
+        futures.push_back(pool.execute([](int x) { return x * 2; }, i));
+    }
+    int total = 0;
+    for (auto &fut : futures) { total += fut.get(); }
+    CHECK(total == 9900);
+
+    auto failed = pool.execute([]() -> int { throw std::runtime_error("boom"); });
+    CHECK_THROWS(failed.get(), std::runtime_error);
+
+    // Tasks queued from inside tasks still run before the pool goes.
+    std::atomic<int> nested{ 0 };
+    {
+        ThreadPool inner(2);
+        for (int i = 0; i < 50; ++i) {
+            inner.post([&]() { inner.post([&]() { nested++; }); });
+        }
+        while (nested < 50) { std::this_thread::yield(); }
+    }
+    CHECK(nested == 50);
+}
+
+// An elastic pool may start with no workers; the first task must start one.
+static void TestElasticFromZero() {
+    ThreadPoolOptions options;
+    options.elastic = true;
+    options.max_threads = 4;
+    ThreadPool pool(0, options);
+    CHECK(pool.size() == 0);
+
+    auto fut = pool.execute([]() { return 7; });
+    CHECK(fut.wait_for(2s) == std::future_status::ready);
+    CHECK(fut.get() == 7);
+    CHECK(pool.size() >= 1);
+}
+
+// A task queued behind a long one must not wait for it to finish.
+static void TestElasticGrowsWhileBusy() {
+    ThreadPoolOptions options;
+    options.elastic = true;
+    options.max_threads = 4;
+    ThreadPool pool(1, options);
+
+    auto slow = pool.execute([]() { std::this_thread::sleep_for(300ms); });
+    std::this_thread::sleep_for(20ms);
+    Clock::time_point submitted = Clock::now();
+    auto quick = pool.execute([]() { return Clock::now(); });
+    CHECK(quick.wait_for(2s) == std::future_status::ready);
+    CHECK(quick.get() - submitted < 150ms);
+    CHECK(pool.size() == 2);
+    slow.get();
+}
+
+// Sustained depth grows the pool to its maximum, then idle workers retire
+//  back down to the minimum.
+static void TestElasticGrowAndRetire() {
+    ThreadPoolOptions options;
+    options.elastic = true;
+    options.max_threads = 8;
+    options.idle_timeout = 100ms;
+    ThreadPool pool(1, options);
+
+    Clock::time_point start = Clock::now();
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 16; ++i) {
+        futures.push_back(pool.execute([]() { std::this_thread::sleep_for(100ms); }));
+    }
+    std::this_thread::sleep_for(50ms);
+    CHECK(pool.size() == 8);
+    for (auto &fut : futures) { fut.get(); }
+    // Two rounds of 100ms on 8 workers, plus growing and scheduling slack.
+    CHECK(Clock::now() - start < 450ms);
+
+    Clock::time_point deadline = Clock::now() + 2s;
+    while (pool.size() > 1 && Clock::now() < deadline) { std::this_thread::sleep_for(10ms); }
+    CHECK(pool.size() == 1);
+
+    // Retired slots are reused, and worker indices stay below the maximum.
+    futures.clear();
+    std::atomic<size_t> highest{ 0 };
+    for (int i = 0; i < 16; ++i) {
+        futures.push_back(pool.execute([&]() {
+            std::this_thread::sleep_for(20ms);
+            size_t index = ThreadPool::current_worker()->index;
+            size_t seen = highest.load();
+            while (index > seen && !highest.compare_exchange_weak(seen, index)) {}
+        }));
+    }
+    for (auto &fut : futures) { fut.get(); }
+    CHECK(highest < pool.max_size());
+}
+
+// Short bursts that the idle workers soon clear must not grow the pool.
+static void TestElasticIgnoresBursts() {
+    for (unsigned int spin : { 2000u, 0u }) {
+        ThreadPoolOptions options;
+        options.elastic = true;
+        options.max_threads = 16;
+        options.spin_iterations = spin;
+        options.backlog_window = 50ms;
+        ThreadPool pool(4, options);
+
+        for (int burst = 0; burst < 5; ++burst) {
+            std::atomic<int> done{ 0 };
+            for (int i = 0; i < 8; ++i) { pool.post([&]() { done++; }); }
+            while (done < 8) { std::this_thread::yield(); }
+            std::this_thread::sleep_for(5ms);
+        }
+        CHECK(pool.size() == 4);
+    }
+}
+
+// Destroying a pool while it is growing must join everything cleanly and
+//  run every queued task.
+static void TestDestroyWhileGrowing() {
+    std::atomic<int> ran{ 0 };
+    for (int round = 0; round < 20; ++round) {
+        ThreadPoolOptions options;
+        options.elastic = true;
+        options.max_threads = 8;
+        options.backlog_window = 0ms;
+        ThreadPool pool(round % 2, options);
+        for (int i = 0; i < 100; ++i) {
+            pool.post([&]() {
+                std::this_thread::sleep_for(50us);
+                ran++;
+            });
+        }
+    }
+    CHECK(ran == 2000);
+}
+
+int main() {
+    RUN(TestResults);
+    RUN(TestElasticFromZero);
+    RUN(TestElasticGrowsWhileBusy);
+    RUN(TestElasticGrowAndRetire);
+    RUN(TestElasticIgnoresBursts);
+    RUN(TestDestroyWhileGrowing);
+    return CheckFailures() == 0 ? 0 : 1;
+}